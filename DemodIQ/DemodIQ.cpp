@@ -0,0 +1,397 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+
+/* DemodIQ
+** Command line program that demodulates a 12KHz rate stereo I/Q file, as SliceIQ writes, into a
+** 12KHz mono 16 bit audio file. The DSP is SimpleSdrImpl's, so the audio is what ReviewRecordedIQ
+** plays, but it runs as fast as the processors allow instead of in real time.
+**
+** DemodIQ <InputFile.wav> <OutputFile.wav>
+**
+** --mode=usb|lsb|cw
+**      Sets the Weaver frequency and bandwidth the way ReviewRecordedIQ's Decoding Presets do. usb is the default.
+** --centerHz=nnnn
+**      The center of the filter, relative to the center of the input. Default 0.
+** --weaverHz=nnnn
+**      overrides the mode's Weaver frequency.
+** --bandwidth=narrowcw|widecw|narrowssb|widessb
+**      overrides the mode's bandwidth.
+** --startOffsetSeconds=nnnn
+** --intervalSeconds=nnnn
+**      Demodulate only that much of the input, from that far into it. The default is all of it.
+** --threads=N
+**      Split the input into N segments and demodulate them at the same time on N threads. The default is
+**      the number of processors. Each thread first runs the filters over the frames just ahead of its
+**      segment, and discards that audio, so the output is identical to the single thread one.
+**
+** The whole output is held in memory (4 bytes per frame, or about 170MB per hour) until the end, where it is
+** scaled so its loudest sample is half of full scale, the level SimpleSdrImpl's gain control settles on.
+*/
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <stdexcept>
+
+#include <RiffReader.h>
+#include <AsyncWriter.h>
+#include <SimpleSdrImpl.h>
+
+namespace {
+    const char ModeArg[] = "--mode=";
+    const char CenterHzArg[] = "--centerHz=";
+    const char WeaverHzArg[] = "--weaverHz=";
+    const char BandwidthArg[] = "--bandwidth=";
+    const char StartSecondsArg[] = "--startOffsetSeconds=";
+    const char IntervalSecondsArg[] = "--intervalSeconds=";
+    const char ThreadsArg[] = "--threads=";
+
+    typedef XDSdr::impl::SimpleSDR SimpleSDR;
+    typedef XDSdr::impl::SimpleSdrDemodulator SimpleSdrDemodulator;
+
+    const uint32_t WAV_HEADER_BYTES = 44;
+
+    int usage()
+    {
+        std::cerr << "Usage: DemodIQ [inputFile.wav] [outputFile.wav] [" << ModeArg << "usb|lsb|cw] [" << CenterHzArg << "f] ["
+            << WeaverHzArg << "f]" << std::endl
+            << " [" << BandwidthArg << "narrowcw|widecw|narrowssb|widessb] [" << StartSecondsArg << "s] [" << IntervalSecondsArg << "s]"
+            << std::endl
+            << " [" << ThreadsArg << "n]"
+            << std::endl;
+        return 1;
+    }
+
+    struct DemodSettings {
+        DemodSettings()
+            : centerHz(0)
+            , weaverHz(1100)
+            , bandwidth(SimpleSDR::WIDE_SSB)
+        {}
+        float centerHz;
+        float weaverHz;
+        SimpleSDR::SdrDecodeBandwidth bandwidth;
+    };
+
+    // Demodulate input frames beginFrame through endFrame-1 of the interval that starts at firstFrame
+    // of the input, on this thread, with a read of the input of its own.
+    void demodSegment(const std::string& inputFileName, const DemodSettings& settings, uint64_t firstFrame,
+        unsigned beginFrame, unsigned endFrame, float* audio)
+    {
+        std::ifstream inputFile(inputFileName.c_str(), std::ifstream::binary);
+        if (!inputFile.is_open())
+            throw std::runtime_error("Failed to open input \"" + inputFileName + "\"");
+        RiffReader rr(inputFile);
+        rr.MapFile(inputFileName);
+        rr.ParseHeader();
+        if (!rr.FindDataChunk())
+            throw std::runtime_error("Input \"" + inputFileName + "\" has no data");
+
+        SimpleSdrDemodulator demod;
+        demod.SetRxFrequencyCenterHz(settings.centerHz);
+        demod.SetRxFrequencyBfoOffsetHz(settings.weaverHz);
+        demod.SetBandwidth(settings.bandwidth);
+
+        // The warmup and the segments are whole blocks, so every thread hands the demodulator
+        // the same blocks that a single thread would have.
+        const unsigned blockFrames = SimpleSdrDemodulator::get_blockFrames();
+        const unsigned WARMUP_FRAMES = (SimpleSdrDemodulator::get_historyFrames() + blockFrames - 1) / blockFrames * blockFrames;
+        const unsigned warmup = std::min(beginFrame, WARMUP_FRAMES);
+        demod.SkipFrames(beginFrame - warmup);
+
+        std::vector<float> block(2 * blockFrames);
+        std::vector<float> discard(blockFrames);
+        unsigned inBlock = 0;
+        unsigned toDiscard = warmup;
+        auto demodBlock = [&]()
+        {
+            if (toDiscard > 0)
+            {
+                demod.Process(&block[0], inBlock, &discard[0]);
+                toDiscard -= inBlock;
+            }
+            else
+            {
+                demod.Process(&block[0], inBlock, audio);
+                audio += inBlock;
+            }
+            inBlock = 0;
+        };
+        const unsigned blockAlign = rr.get_blockAlign();
+        rr.ProcessFrames(firstFrame + beginFrame - warmup, endFrame - beginFrame + warmup,
+            [&](unsigned char* p, unsigned numFrames)
+            {
+                while (numFrames > 0)
+                {
+                    unsigned n = std::min(numFrames, blockFrames - inBlock);
+                    memcpy(&block[2 * inBlock], p, n * blockAlign);
+                    inBlock += n;
+                    p += n * blockAlign;
+                    numFrames -= n;
+                    if (inBlock == blockFrames)
+                        demodBlock();
+                }
+                return true;
+            });
+        if (inBlock > 0)
+            demodBlock();
+    }
+
+    void put16(unsigned char* p, uint16_t v)
+    {
+        p[0] = static_cast<unsigned char>(v);
+        p[1] = static_cast<unsigned char>(v >> 8);
+    }
+
+    void put32(unsigned char* p, uint32_t v)
+    {
+        put16(p, static_cast<uint16_t>(v));
+        put16(p + 2, static_cast<uint16_t>(v >> 16));
+    }
+
+    bool writeWav(const std::string& outputFileName, const std::vector<float>& audio)
+    {
+        CAsyncWriter outputFile;
+        if (!outputFile.Open(outputFileName))
+        {
+            std::cerr << "Failed to open output \"" << outputFileName << "\"" << std::endl;
+            return false;
+        }
+        const uint32_t rate = SimpleSdrDemodulator::get_framesPerSecond();
+        const uint32_t dataBytes = static_cast<uint32_t>(audio.size() * sizeof(short));
+        unsigned char h[WAV_HEADER_BYTES];
+        memcpy(h, "RIFF", 4);
+        put32(h + 4, WAV_HEADER_BYTES - 8 + dataBytes);
+        memcpy(h + 8, "WAVEfmt ", 8);
+        put32(h + 16, 16); // fmt chunk size
+        put16(h + 20, 1); // PCM
+        put16(h + 22, 1); // mono
+        put32(h + 24, rate);
+        put32(h + 28, rate * sizeof(short));
+        put16(h + 32, sizeof(short));
+        put16(h + 34, 8 * sizeof(short));
+        memcpy(h + 36, "data", 4);
+        put32(h + 40, dataBytes);
+        outputFile.Preallocate(WAV_HEADER_BYTES + static_cast<uint64_t>(dataBytes));
+        outputFile.Write(h, sizeof(h));
+
+        float peak = 0;
+        for (auto a : audio)
+            peak = std::max(peak, std::fabs(a));
+        const double gain = peak > 0 ? 0x7FFF * 0.5 / peak : 0;
+        std::vector<short> sound(1 << 16);
+        for (size_t i = 0; i < audio.size(); i += sound.size())
+        {
+            size_t n = std::min(sound.size(), audio.size() - i);
+            for (size_t j = 0; j < n; j++)
+                sound[j] = static_cast<short>(gain * audio[i + j]); // WAV is little endian, as is every machine this runs on
+            outputFile.Write(&sound[0], n * sizeof(short));
+        }
+        if (!outputFile.Close())
+        {
+            std::cerr << "Failed writing output \"" << outputFileName << "\"" << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string inputFileName;
+    std::string outputFileName;
+    DemodSettings settings;
+    // --weaverHz and --bandwidth override --mode wherever they appear
+    bool weaverSpecified = false;
+    float weaverHz = 0;
+    bool bandwidthSpecified = false;
+    SimpleSDR::SdrDecodeBandwidth bandwidth = SimpleSDR::WIDE_SSB;
+    double startOffsetSeconds = 0;
+    double intervalSeconds = -1;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // parse command line arguments
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.find("--") != 0)
+        {
+            if (inputFileName.empty())
+                inputFileName = arg;
+            else if (outputFileName.empty())
+                outputFileName = arg;
+            else
+                std::cerr << "Illegal command argument \"" << arg << "\"" << std::endl;
+        }
+        else if (arg.find(ModeArg) == 0)
+        {
+            std::string v = arg.substr(sizeof(ModeArg) - 1);
+            if (v == "usb")
+            {
+                settings.weaverHz = 1100;
+                settings.bandwidth = SimpleSDR::WIDE_SSB;
+            }
+            else if (v == "lsb")
+            {
+                settings.weaverHz = -1100;
+                settings.bandwidth = SimpleSDR::WIDE_SSB;
+            }
+            else if (v == "cw")
+            {
+                settings.weaverHz = 500;
+                settings.bandwidth = SimpleSDR::WIDE_CW;
+            }
+            else
+            {
+                std::cerr << "Unrecognized mode \"" << v << "\"" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg.find(CenterHzArg) == 0)
+            settings.centerHz = static_cast<float>(atof(arg.substr(sizeof(CenterHzArg) - 1).c_str()));
+        else if (arg.find(WeaverHzArg) == 0)
+        {
+            weaverHz = static_cast<float>(atof(arg.substr(sizeof(WeaverHzArg) - 1).c_str()));
+            weaverSpecified = true;
+        }
+        else if (arg.find(BandwidthArg) == 0)
+        {
+            std::string v = arg.substr(sizeof(BandwidthArg) - 1);
+            if (v == "narrowcw")
+                bandwidth = SimpleSDR::NARROW_CW;
+            else if (v == "widecw")
+                bandwidth = SimpleSDR::WIDE_CW;
+            else if (v == "narrowssb")
+                bandwidth = SimpleSDR::NARROW_SSB;
+            else if (v == "widessb")
+                bandwidth = SimpleSDR::WIDE_SSB;
+            else
+            {
+                std::cerr << "Unrecognized bandwidth \"" << v << "\"" << std::endl;
+                return 1;
+            }
+            bandwidthSpecified = true;
+        }
+        else if (arg.find(StartSecondsArg) == 0)
+            startOffsetSeconds = atof(arg.substr(sizeof(StartSecondsArg) - 1).c_str());
+        else if (arg.find(IntervalSecondsArg) == 0)
+            intervalSeconds = atof(arg.substr(sizeof(IntervalSecondsArg) - 1).c_str());
+        else if (arg.find(ThreadsArg) == 0)
+        {
+            int n = atoi(arg.substr(sizeof(ThreadsArg) - 1).c_str());
+            if (n < 1)
+            {
+                std::cerr << arg << " must be at least one" << std::endl;
+                return 1;
+            }
+            threads = static_cast<unsigned>(n);
+        }
+        else
+        {
+            std::cerr << "Unrecognized command argument: \"" << arg << "\"" << std::endl;
+            return 1;
+        }
+    }
+    if (weaverSpecified)
+        settings.weaverHz = weaverHz;
+    if (bandwidthSpecified)
+        settings.bandwidth = bandwidth;
+
+    // validate command line arguments
+    if (inputFileName.empty() || outputFileName.empty())
+    {
+        std::cerr << (inputFileName.empty() ? "No input file specified" : "No output file specified") << std::endl;
+        return usage();
+    }
+    const unsigned rate = SimpleSdrDemodulator::get_framesPerSecond();
+    if (startOffsetSeconds < 0 || std::fabs(settings.centerHz) >= rate / 2 || std::fabs(settings.weaverHz) >= rate / 2)
+    {
+        std::cerr << StartSecondsArg << " cannot be negative, nor the frequencies beyond " << rate / 2 << "Hz" << std::endl;
+        return 1;
+    }
+
+    std::ifstream inputFile(inputFileName.c_str(), std::ifstream::binary);
+    if (!inputFile.is_open())
+    {
+        std::cerr << "Failed to open input \"" << inputFileName << "\"" << std::endl;
+        return 1;
+    }
+    RiffReader rr(inputFile);
+    try {
+        rr.ParseHeader();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (rr.get_numChannels() != 2 || rr.get_format() != 3 || rr.get_bitsPerSample() != 32 || rr.get_sampleRate() != rate)
+    {
+        std::cerr << "Input must be " << rate << " frames per second stereo 32 bit float I/Q" << std::endl;
+        return 1;
+    }
+    if (!rr.FindDataChunk())
+    {
+        std::cerr << "Input \"" << inputFileName << "\" has no data" << std::endl;
+        return 1;
+    }
+    const uint64_t totalFrames = rr.get_dataChunkSize() / rr.get_blockAlign();
+    const uint64_t firstFrame = static_cast<uint64_t>(std::min<double>(startOffsetSeconds * rate, static_cast<double>(totalFrames)));
+    uint64_t framesToDemodulate = totalFrames - firstFrame;
+    if (intervalSeconds >= 0)
+        framesToDemodulate = static_cast<uint64_t>(std::min<double>(intervalSeconds * rate, static_cast<double>(framesToDemodulate)));
+    const uint64_t maxOutputFrames = 0x7FFFFFFF; // of 16 bit audio, within the 32 bit sizes of the output RIFF
+    if (framesToDemodulate > maxOutputFrames)
+    {
+        std::cerr << "Cannot write more than " << maxOutputFrames / rate << " seconds of audio to one file" << std::endl;
+        return 1;
+    }
+    const unsigned numFrames = static_cast<unsigned>(framesToDemodulate);
+    if (numFrames == 0)
+    {
+        std::cerr << "Nothing to demodulate" << std::endl;
+        return 1;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    const unsigned blockFrames = SimpleSdrDemodulator::get_blockFrames();
+    const unsigned segmentFrames = ((numFrames + threads - 1) / threads + blockFrames - 1) / blockFrames * blockFrames;
+    std::vector<float> audio(numFrames);
+    std::vector<std::string> errors(threads);
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads && static_cast<uint64_t>(i) * segmentFrames < numFrames; i++)
+    {
+        unsigned beginFrame = i * segmentFrames;
+        unsigned endFrame = static_cast<unsigned>(std::min<uint64_t>(static_cast<uint64_t>(beginFrame) + segmentFrames, numFrames));
+        workers.emplace_back([&, i, beginFrame, endFrame]()
+        {
+            try {
+                demodSegment(inputFileName, settings, firstFrame, beginFrame, endFrame, &audio[beginFrame]);
+            }
+            catch (const std::exception& e)
+            {
+                errors[i] = e.what();
+            }
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+    for (auto& e : errors)
+        if (!e.empty())
+        {
+            std::cerr << e << std::endl;
+            return 1;
+        }
+
+    if (!writeWav(outputFileName, audio))
+        return 1;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    double seconds = static_cast<double>(numFrames) / rate;
+    std::cerr << "Demodulated " << seconds << " seconds in " << elapsed << " seconds on " << workers.size()
+        << " threads (" << (elapsed > 0 ? seconds / elapsed : 0) << " times real time)" << std::endl;
+    return 0;
+}
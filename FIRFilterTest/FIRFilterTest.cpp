@@ -0,0 +1,193 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+
+/* FIRFilterTest
+** Command line program that checks CFIRFilterT<double> and CFIRFilterT<float> against a direct sum
+** of the coefficients times the history. Each of the AVX2, SSE2 and scalar kernels the CPU has is run
+** in turn, on odd and even lengths, symmetric coefficients (which the filter folds) and asymmetric ones
+** (which it does not), and the tables SliceIQ and SimpleSdrImpl actually use. Both value() after
+** each applySample() and applyBlock() with and without decimation are compared.
+**
+** The kernels sum in several lanes at once, so they round differently than the direct sum. The test
+** fails if the difference exceeds 8e-15 for double or 2e-6 for float, with samples in [-1, 1].
+**
+** FIRFilterTest
+**      Prints the largest difference for each kernel, and any case that exceeded its tolerance.
+**      Exits with 1 if there was one.
+*/
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+#include <FIRFilter.h>
+#include "../SliceIQ/FilterOctave.h"
+#include "../SimpleSDR/BandwidthFilters.h"
+
+namespace {
+    const double DOUBLE_TOLERANCE = 8e-15;
+    const double FLOAT_TOLERANCE = 2e-6;
+    const unsigned NUM_SAMPLES = 2000;
+
+    std::mt19937 generator(12345);
+
+    std::vector<double> RandomSamples(unsigned n)
+    {
+        std::uniform_real_distribution<double> d(-1, 1);
+        std::vector<double> ret(n);
+        for (auto& v : ret)
+            v = d(generator);
+        return ret;
+    }
+
+    std::vector<FilterCoeficient_t> RandomTaps(unsigned len, bool symmetric)
+    {
+        std::vector<FilterCoeficient_t> ret = RandomSamples(len);
+        for (auto& v : ret)
+            v /= len; // keep the sum near the scale of the real tables
+        if (symmetric)
+            for (unsigned i = 0; i < len / 2; i++)
+                ret[len - 1 - i] = ret[i];
+        else if (len > 1 && ret[0] == ret[len - 1])
+            ret[0] += 1.0 / len;
+        return ret;
+    }
+
+    // Compare one filter, with samples as Sample_t, to the sum done the obvious way.
+    // Returns the largest difference.
+    template <class Sample_t>
+    double Check(const std::vector<FilterCoeficient_t>& taps, const std::vector<double>& samples,
+        bool expectSymmetric, bool& ok)
+    {
+        const unsigned len = static_cast<unsigned>(taps.size());
+        std::vector<Sample_t> in(samples.begin(), samples.end());
+        std::vector<double> h(len);
+        for (unsigned i = 0; i < len; i++)
+            h[i] = static_cast<Sample_t>(taps[i]); // the filter keeps its coefficients as Sample_t
+
+        // expected[j] is the filter's value after sample j
+        std::vector<double> expected(in.size());
+        for (unsigned j = 0; j < in.size(); j++)
+        {
+            double sum = 0;
+            for (unsigned i = 0; i < len; i++)
+            {   // coefficient zero goes with the oldest sample, len - 1 back
+                int k = static_cast<int>(j) - static_cast<int>(len - 1) + static_cast<int>(i);
+                if (k >= 0)
+                    sum += h[i] * in[k];
+            }
+            expected[j] = sum;
+        }
+
+        double maxErr = 0;
+        auto compare = [&](Sample_t v, unsigned j) {
+            maxErr = std::max(maxErr, std::fabs(v - expected[j]));
+        };
+
+        CFIRFilterT<Sample_t> filter(len, &taps[0]);
+        if (filter.get_isSymmetric() != expectSymmetric)
+            ok = false;
+        for (unsigned j = 0; j < in.size(); j++)
+        {
+            filter.applySample(in[j]);
+            compare(filter.value(), j);
+        }
+
+        // applyBlock, full rate and decimated, fed in uneven pieces so the decimation
+        // phase has to carry across calls.
+        for (unsigned decimate = 1; decimate <= 3; decimate += 2)
+        {
+            CFIRFilterT<Sample_t> blocked(len, &taps[0]);
+            std::vector<Sample_t> out(in.size() + 1);
+            unsigned numIn = 0;
+            unsigned numOut = 0;
+            for (unsigned block = 1; numIn < in.size(); block = block % 37 + 1)
+            {
+                unsigned n = std::min(block, static_cast<unsigned>(in.size()) - numIn);
+                numOut += blocked.applyBlock(&in[numIn], n, &out[numOut], decimate);
+                numIn += n;
+            }
+            if (numOut != in.size() / decimate)
+                ok = false;
+            for (unsigned j = 0; j < numOut; j++)
+                compare(out[j], (j + 1) * decimate - 1);
+        }
+        return maxErr;
+    }
+
+    struct Totals {
+        double worstDouble = 0;
+        double worstFloat = 0;
+        bool ok = true;
+    };
+
+    void CheckTaps(const std::string& name, const std::vector<FilterCoeficient_t>& taps,
+        bool expectSymmetric, Totals& totals)
+    {
+        auto samples = RandomSamples(NUM_SAMPLES);
+        bool ok = true;
+        double d = Check<double>(taps, samples, expectSymmetric, ok);
+        double f = Check<float>(taps, samples, expectSymmetric, ok);
+        totals.worstDouble = std::max(totals.worstDouble, d);
+        totals.worstFloat = std::max(totals.worstFloat, f);
+        if (d > DOUBLE_TOLERANCE || f > FLOAT_TOLERANCE)
+            ok = false;
+        if (!ok)
+        {
+            totals.ok = false;
+            std::cout << "    " << name << " double " << d << " float " << f
+                << " FAILED" << std::endl;
+        }
+    }
+}
+
+int main(int, char* [])
+{
+    struct {
+        FIRKernels::InstructionSet is;
+        const char* name;
+    } const instructionSets[] = {
+        { FIRKernels::AVX2, "avx2" },
+        { FIRKernels::SSE2, "sse2" },
+        { FIRKernels::SCALAR, "scalar" },
+    };
+
+    const struct {
+        const char* name;
+        const FilterCoeficient_t* taps;
+        unsigned len;
+    } tables[] = {
+        { "Filter_Octave", Filter_Octave::filter_taps, static_cast<unsigned>(Filter_Octave::SAMPLEFILTER_TAP_NUM) },
+        { "NARROW_CW_FILTER", NARROW_CW_FILTER::filter_taps, NARROW_CW_FILTER::SAMPLEFILTER_TAP_NUM },
+        { "WIDE_CW_FILTER", WIDE_CW_FILTER::filter_taps, WIDE_CW_FILTER::SAMPLEFILTER_TAP_NUM },
+        { "NARROW_SSB_FILTER", NARROW_SSB_FILTER::filter_taps, NARROW_SSB_FILTER::SAMPLEFILTER_TAP_NUM },
+        { "WIDE_SSB_FILTER", WIDE_SSB_FILTER::filter_taps, WIDE_SSB_FILTER::SAMPLEFILTER_TAP_NUM },
+    };
+
+    bool ok = true;
+    for (const auto& is : instructionSets)
+    {
+        if (!FIRKernels::Use(is.is))
+        {
+            std::cout << is.name << ": not available on this CPU, skipped" << std::endl;
+            continue;
+        }
+        Totals totals;
+        generator.seed(12345); // each kernel sees the same samples
+        for (unsigned len = 1; len < 80; len++)
+        {
+            CheckTaps("symmetric " + std::to_string(len), RandomTaps(len, true), true, totals);
+            // a single coefficient is its own mirror image
+            CheckTaps("asymmetric " + std::to_string(len), RandomTaps(len, false), len == 1, totals);
+        }
+        for (const auto& t : tables)
+            CheckTaps(t.name, std::vector<FilterCoeficient_t>(t.taps, t.taps + t.len), true, totals);
+        std::cout << is.name << ": worst double " << totals.worstDouble << " float " << totals.worstFloat
+            << (totals.ok ? " ok" : " FAILED") << std::endl;
+        if (!totals.ok)
+            ok = false;
+    }
+    std::cout << (ok ? "All passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
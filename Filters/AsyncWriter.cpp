@@ -0,0 +1,196 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#include "AsyncWriter.h"
+#include <algorithm>
+#include <cstring>
+#if defined(_WIN32)
+#define NOMINMAX
+#include <Windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <sys/types.h>
+#endif
+
+namespace {
+    const size_t WRITE_BUFFER_BYTES = 1 << 20;
+
+    int seek64(FILE* f, uint64_t position)
+    {
+#if defined(_WIN32)
+        return _fseeki64(f, static_cast<__int64>(position), SEEK_SET);
+#else
+        return fseeko(f, static_cast<off_t>(position), SEEK_SET);
+#endif
+    }
+}
+
+CAsyncWriter::CAsyncWriter()
+    : m_file(nullptr)
+    , m_position(0)
+    , m_maxQueueDepth(0)
+    , m_seekable(true)
+    , m_failed(false)
+    , m_stop(false)
+{}
+
+CAsyncWriter::~CAsyncWriter()
+{
+    Close();
+}
+
+bool CAsyncWriter::Open(const std::string& fileName, bool truncate)
+{
+    Close();
+    if (fileName == "-")
+    {
+        m_file = stdout;
+#if defined(_WIN32)
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        m_seekable = seek64(m_file, 0) == 0; // a file, not a pipe
+    }
+    else
+    {
+        m_file = fopen(fileName.c_str(), truncate ? "wb" : "r+b");
+        if (m_file == nullptr)
+            return false;
+        m_seekable = true;
+    }
+    setvbuf(m_file, nullptr, _IONBF, 0); // we do our own buffering
+    m_position = 0;
+    m_failed = false;
+    m_stop = false;
+    m_maxQueueDepth = 0;
+    m_thread = std::thread(&CAsyncWriter::thread, this);
+    return true;
+}
+
+void CAsyncWriter::Preallocate(uint64_t bytes)
+{
+    if (m_file == nullptr || bytes == 0 || !m_seekable)
+        return;
+#if defined(_WIN32)
+    FILE_ALLOCATION_INFO info;
+    info.AllocationSize.QuadPart = static_cast<LONGLONG>(bytes);
+    SetFileInformationByHandle(reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(m_file))),
+        FileAllocationInfo, &info, sizeof(info));
+#elif defined(__linux__)
+    fallocate(fileno(m_file), FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(bytes));
+#endif
+}
+
+void CAsyncWriter::Write(const void* p, size_t bytes)
+{
+    auto src = static_cast<const unsigned char*>(p);
+    while (bytes > 0)
+    {
+        if (!m_current)
+        {
+            lock_t l(m_mutex);
+            if (!m_free.empty())
+            {
+                m_current = std::move(m_free.back());
+                m_free.pop_back();
+            }
+            else
+            {
+                l.unlock();
+                m_current.reset(new Buffer());
+                m_current->data.resize(WRITE_BUFFER_BYTES);
+            }
+            m_current->bytes = 0;
+            m_current->position = m_position;
+        }
+        // (after a Seek back into it, m_position can be short of the buffer's end)
+        size_t offset = static_cast<size_t>(m_position - m_current->position);
+        size_t n = std::min(bytes, m_current->data.size() - offset);
+        memcpy(&m_current->data[offset], src, n);
+        m_current->bytes = std::max(m_current->bytes, offset + n);
+        m_position += n;
+        src += n;
+        bytes -= n;
+        if (offset + n == m_current->data.size())
+            queueCurrent();
+    }
+}
+
+void CAsyncWriter::Flush()
+{
+    queueCurrent();
+}
+
+void CAsyncWriter::Seek(uint64_t position)
+{
+    if (m_current && position >= m_current->position && position <= m_current->position + m_current->bytes)
+    {   // still in the buffer
+        m_position = position;
+        return;
+    }
+    queueCurrent();
+    m_position = position;
+}
+
+bool CAsyncWriter::Close()
+{
+    if (m_file == nullptr)
+        return !m_failed;
+    queueCurrent();
+    {
+        lock_t l(m_mutex);
+        m_stop = true;
+        m_cond.notify_all();
+    }
+    m_thread.join();
+    if ((m_file == stdout ? fflush(m_file) : fclose(m_file)) != 0)
+        m_failed = true;
+    m_file = nullptr;
+    return !m_failed;
+}
+
+unsigned CAsyncWriter::get_maxQueueDepth() const
+{
+    lock_t l(m_mutex);
+    return m_maxQueueDepth;
+}
+
+void CAsyncWriter::queueCurrent()
+{
+    if (!m_current)
+        return;
+    if (m_current->bytes == 0)
+    {
+        lock_t l(m_mutex);
+        m_free.push_back(std::move(m_current));
+        return;
+    }
+    lock_t l(m_mutex);
+    m_queue.push_back(std::move(m_current));
+    m_maxQueueDepth = std::max(m_maxQueueDepth, static_cast<unsigned>(m_queue.size()));
+    m_cond.notify_all();
+}
+
+void CAsyncWriter::thread()
+{
+    lock_t l(m_mutex);
+    uint64_t filePosition = m_seekable ? static_cast<uint64_t>(-1) : 0; // a pipe is where it is
+    for (;;)
+    {
+        while (!m_stop && m_queue.empty())
+            m_cond.wait(l);
+        if (m_queue.empty())
+            return; // stopped, and everything is written
+        std::unique_ptr<Buffer> b = std::move(m_queue.front());
+        m_queue.pop_front();
+        l.unlock();
+        bool ok = true;
+        if (filePosition != b->position)
+            ok = m_seekable && seek64(m_file, b->position) == 0;
+        ok = ok && fwrite(&b->data[0], 1, b->bytes, m_file) == b->bytes;
+        filePosition = ok ? b->position + b->bytes : static_cast<uint64_t>(-1);
+        l.lock();
+        if (!ok)
+            m_failed = true;
+        m_free.push_back(std::move(b));
+    }
+}
@@ -0,0 +1,76 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+
+// Writes a file on a background thread. Write only copies into a large buffer, and full
+// buffers are queued for the thread. If the disk falls behind, more buffers are allocated
+// rather than make the caller wait.
+// The file name "-" is standard output, which might be a pipe that can't seek. A Seek that stays inside
+// the buffer not yet queued works regardless, so a header can be filled in before it is written.
+class CAsyncWriter
+{
+public:
+    CAsyncWriter();
+    ~CAsyncWriter(); // closes the file if Close wasn't called
+
+    // truncate false opens an existing file without discarding its contents, so that
+    // more than one CAsyncWriter can write (different parts of) it at the same time.
+    bool Open(const std::string& fileName, bool truncate = true);
+
+    // Reserve disk space for bytes of file so the writes don't fragment it.
+    // The file's size is not changed.
+    void Preallocate(uint64_t bytes);
+
+    // Queue bytes to be written at the current position, which then advances past them.
+    void Write(const void* p, size_t bytes);
+
+    // Queue what has been written so far, rather than wait for a full buffer.
+    void Flush();
+
+    // Move the position for the next Write.
+    void Seek(uint64_t position);
+    uint64_t get_position() const { return m_position; }
+
+    // false for a standard output that can't seek. Seek then only works inside the current buffer.
+    bool get_seekable() const { return m_seekable; }
+
+    // Waits for everything queued to be written, and closes the file.
+    // Returns false if anything failed to write.
+    bool Close();
+
+    // The most buffers that were ever waiting for the disk.
+    unsigned get_maxQueueDepth() const;
+
+private:
+    CAsyncWriter(const CAsyncWriter&) = delete;
+    CAsyncWriter& operator = (const CAsyncWriter&) = delete;
+    typedef std::unique_lock<std::mutex> lock_t;
+    struct Buffer {
+        std::vector<unsigned char> data;
+        size_t bytes;
+        uint64_t position;
+    };
+    void queueCurrent();
+    void thread();
+
+    FILE* m_file;
+    uint64_t m_position;
+    std::unique_ptr<Buffer> m_current;
+    std::deque<std::unique_ptr<Buffer>> m_queue;
+    std::vector<std::unique_ptr<Buffer>> m_free;
+    unsigned m_maxQueueDepth;
+    bool m_seekable;
+    bool m_failed;
+    bool m_stop;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+};
@@ -1,4 +1,315 @@
 /* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
 #include "FIRFilter.h"
 
-const FilterCoeficient_t CFIRFilter::Dummy(1.0);
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FIR_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_AVX2_FMA
+#else
+#define TARGET_AVX2_FMA __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+namespace {
+    template <class T>
+    T dotScalar(const T* x, const T* h, unsigned n)
+    {
+        T v = 0;
+        for (unsigned i = 0; i < n; i++)
+            v += x[i] * h[i];
+        return v;
+    }
+
+    template <class T>
+    T dotSymmetricScalar(const T* x, const T* h, unsigned n)
+    {
+        const unsigned half = n / 2;
+        T v = 0;
+        for (unsigned i = 0; i < half; i++)
+            v += (x[i] + x[n - 1 - i]) * h[i];
+        if (n & 1)
+            v += x[half] * h[half];
+        return v;
+    }
+
+#if defined(FIR_KERNELS_X86)
+    double dotSse2(const double* x, const double* h, unsigned n)
+    {
+        __m128d a0 = _mm_setzero_pd();
+        __m128d a1 = _mm_setzero_pd();
+        unsigned i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            a0 = _mm_add_pd(a0, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(h + i)));
+            a1 = _mm_add_pd(a1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(h + i + 2)));
+        }
+        a0 = _mm_add_pd(a0, a1);
+        double lanes[2];
+        _mm_storeu_pd(lanes, a0);
+        double v = lanes[0] + lanes[1];
+        for (; i < n; i++)
+            v += x[i] * h[i];
+        return v;
+    }
+
+    float dotSse2(const float* x, const float* h, unsigned n)
+    {
+        __m128 a0 = _mm_setzero_ps();
+        __m128 a1 = _mm_setzero_ps();
+        unsigned i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(h + i)));
+            a1 = _mm_add_ps(a1, _mm_mul_ps(_mm_loadu_ps(x + i + 4), _mm_loadu_ps(h + i + 4)));
+        }
+        a0 = _mm_add_ps(a0, a1);
+        float lanes[4];
+        _mm_storeu_ps(lanes, a0);
+        float v = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        for (; i < n; i++)
+            v += x[i] * h[i];
+        return v;
+    }
+
+    // In the symmetric kernels, the loads from the top end of x are lane reversed so they pair
+    // up with the loads from the bottom.
+    double dotSymmetricSse2(const double* x, const double* h, unsigned n)
+    {
+        const unsigned half = n / 2;
+        __m128d a0 = _mm_setzero_pd();
+        unsigned i = 0;
+        for (; i + 2 <= half; i += 2)
+        {
+            __m128d hi = _mm_loadu_pd(x + n - i - 2);
+            __m128d sum = _mm_add_pd(_mm_loadu_pd(x + i), _mm_shuffle_pd(hi, hi, 1));
+            a0 = _mm_add_pd(a0, _mm_mul_pd(sum, _mm_loadu_pd(h + i)));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, a0);
+        double v = lanes[0] + lanes[1];
+        for (; i < half; i++)
+            v += (x[i] + x[n - 1 - i]) * h[i];
+        if (n & 1)
+            v += x[half] * h[half];
+        return v;
+    }
+
+    float dotSymmetricSse2(const float* x, const float* h, unsigned n)
+    {
+        const unsigned half = n / 2;
+        __m128 a0 = _mm_setzero_ps();
+        unsigned i = 0;
+        for (; i + 4 <= half; i += 4)
+        {
+            __m128 hi = _mm_loadu_ps(x + n - i - 4);
+            __m128 sum = _mm_add_ps(_mm_loadu_ps(x + i), _mm_shuffle_ps(hi, hi, _MM_SHUFFLE(0, 1, 2, 3)));
+            a0 = _mm_add_ps(a0, _mm_mul_ps(sum, _mm_loadu_ps(h + i)));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, a0);
+        float v = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        for (; i < half; i++)
+            v += (x[i] + x[n - 1 - i]) * h[i];
+        if (n & 1)
+            v += x[half] * h[half];
+        return v;
+    }
+
+    TARGET_AVX2_FMA double dotAvx2(const double* x, const double* h, unsigned n)
+    {
+        __m256d a0 = _mm256_setzero_pd();
+        __m256d a1 = _mm256_setzero_pd();
+        unsigned i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            a0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(h + i), a0);
+            a1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(h + i + 4), a1);
+        }
+        a0 = _mm256_add_pd(a0, a1);
+        __m128d s = _mm_add_pd(_mm256_castpd256_pd128(a0), _mm256_extractf128_pd(a0, 1));
+        double lanes[2];
+        _mm_storeu_pd(lanes, s);
+        double v = lanes[0] + lanes[1];
+        for (; i < n; i++)
+            v += x[i] * h[i];
+        return v;
+    }
+
+    TARGET_AVX2_FMA float dotAvx2(const float* x, const float* h, unsigned n)
+    {
+        __m256 a0 = _mm256_setzero_ps();
+        __m256 a1 = _mm256_setzero_ps();
+        unsigned i = 0;
+        for (; i + 16 <= n; i += 16)
+        {
+            a0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(h + i), a0);
+            a1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(h + i + 8), a1);
+        }
+        a0 = _mm256_add_ps(a0, a1);
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(a0), _mm256_extractf128_ps(a0, 1));
+        float lanes[4];
+        _mm_storeu_ps(lanes, s);
+        float v = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        for (; i < n; i++)
+            v += x[i] * h[i];
+        return v;
+    }
+
+    TARGET_AVX2_FMA double dotSymmetricAvx2(const double* x, const double* h, unsigned n)
+    {
+        const unsigned half = n / 2;
+        __m256d a0 = _mm256_setzero_pd();
+        unsigned i = 0;
+        for (; i + 4 <= half; i += 4)
+        {
+            __m256d hi = _mm256_permute4x64_pd(_mm256_loadu_pd(x + n - i - 4), _MM_SHUFFLE(0, 1, 2, 3));
+            a0 = _mm256_fmadd_pd(_mm256_add_pd(_mm256_loadu_pd(x + i), hi), _mm256_loadu_pd(h + i), a0);
+        }
+        __m128d s = _mm_add_pd(_mm256_castpd256_pd128(a0), _mm256_extractf128_pd(a0, 1));
+        double lanes[2];
+        _mm_storeu_pd(lanes, s);
+        double v = lanes[0] + lanes[1];
+        for (; i < half; i++)
+            v += (x[i] + x[n - 1 - i]) * h[i];
+        if (n & 1)
+            v += x[half] * h[half];
+        return v;
+    }
+
+    TARGET_AVX2_FMA float dotSymmetricAvx2(const float* x, const float* h, unsigned n)
+    {
+        const unsigned half = n / 2;
+        const __m256i reverse = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256 a0 = _mm256_setzero_ps();
+        unsigned i = 0;
+        for (; i + 8 <= half; i += 8)
+        {
+            __m256 hi = _mm256_permutevar8x32_ps(_mm256_loadu_ps(x + n - i - 8), reverse);
+            a0 = _mm256_fmadd_ps(_mm256_add_ps(_mm256_loadu_ps(x + i), hi), _mm256_loadu_ps(h + i), a0);
+        }
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(a0), _mm256_extractf128_ps(a0, 1));
+        float lanes[4];
+        _mm_storeu_ps(lanes, s);
+        float v = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        for (; i < half; i++)
+            v += (x[i] + x[n - 1 - i]) * h[i];
+        if (n & 1)
+            v += x[half] * h[half];
+        return v;
+    }
+
+    bool hasAvx2Fma()
+    {
+#if defined(_MSC_VER)
+        int r[4];
+        __cpuid(r, 0);
+        if (r[0] < 7)
+            return false;
+        __cpuid(r, 1);
+        const bool fma = (r[2] & (1 << 12)) != 0;
+        const bool osxsave = (r[2] & (1 << 27)) != 0;
+        const bool avx = (r[2] & (1 << 28)) != 0;
+        if (!fma || !osxsave || !avx)
+            return false;
+        if ((_xgetbv(0) & 6) != 6) // the OS saves the YMM registers
+            return false;
+        __cpuidex(r, 7, 0);
+        return (r[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    }
+#endif
+
+    // chosen once, on first use, unless FIRKernels::Use changes it
+    struct Kernels {
+        Kernels()
+        {
+#if defined(FIR_KERNELS_X86)
+            set(hasAvx2Fma() ? FIRKernels::AVX2 : FIRKernels::SSE2);
+#else
+            set(FIRKernels::SCALAR);
+#endif
+        }
+        void set(FIRKernels::InstructionSet is)
+        {
+            switch (is)
+            {
+#if defined(FIR_KERNELS_X86)
+            case FIRKernels::AVX2:
+                dotDouble = &dotAvx2;
+                dotFloat = &dotAvx2;
+                dotSymmetricDouble = &dotSymmetricAvx2;
+                dotSymmetricFloat = &dotSymmetricAvx2;
+                break;
+            case FIRKernels::SSE2:
+                dotDouble = &dotSse2;
+                dotFloat = &dotSse2;
+                dotSymmetricDouble = &dotSymmetricSse2;
+                dotSymmetricFloat = &dotSymmetricSse2;
+                break;
+#endif
+            default:
+                dotDouble = &dotScalar<double>;
+                dotFloat = &dotScalar<float>;
+                dotSymmetricDouble = &dotSymmetricScalar<double>;
+                dotSymmetricFloat = &dotSymmetricScalar<float>;
+                break;
+            }
+        }
+        double(*dotDouble)(const double*, const double*, unsigned);
+        float(*dotFloat)(const float*, const float*, unsigned);
+        double(*dotSymmetricDouble)(const double*, const double*, unsigned);
+        float(*dotSymmetricFloat)(const float*, const float*, unsigned);
+    };
+
+    Kernels& kernels()
+    {
+        static Kernels k;
+        return k;
+    }
+}
+
+bool FIRKernels::Use(InstructionSet is)
+{
+    switch (is)
+    {
+    case SCALAR:
+        break;
+#if defined(FIR_KERNELS_X86)
+    case SSE2:
+        break;
+    case AVX2:
+        if (!hasAvx2Fma())
+            return false;
+        break;
+#endif
+    default:
+        return false;
+    }
+    kernels().set(is);
+    return true;
+}
+
+double FIRKernels::Dot(const double* x, const double* h, unsigned n)
+{
+    return kernels().dotDouble(x, h, n);
+}
+
+float FIRKernels::Dot(const float* x, const float* h, unsigned n)
+{
+    return kernels().dotFloat(x, h, n);
+}
+
+double FIRKernels::DotSymmetric(const double* x, const double* h, unsigned n)
+{
+    return kernels().dotSymmetricDouble(x, h, n);
+}
+
+float FIRKernels::DotSymmetric(const float* x, const float* h, unsigned n)
+{
+    return kernels().dotSymmetricFloat(x, h, n);
+}
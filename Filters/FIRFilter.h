@@ -6,79 +6,128 @@
 
 typedef double FilterCoeficient_t;
 
+// The inner loop of the filters. AVX2/FMA when the CPU has it, else SSE2 (or plain C++
+// on CPUs that are not x86.) The sum is accumulated in several lanes at once, so its
+// rounding differs from a sequential sum in the last bits.
+class FIRKernels {
+public:
+    // sum of x[i] * h[i] for i = 0 through n-1
+    static double Dot(const double* x, const double* h, unsigned n);
+    static float Dot(const float* x, const float* h, unsigned n);
+    // The same sum for symmetric h, that is h[i] == h[n-1-i], where only the first (n+1)/2 of h are
+    // passed. Pairs of x are added before the multiply, x[i] + x[n-1-i], which halves the multiplies.
+    static double DotSymmetric(const double* x, const double* h, unsigned n);
+    static float DotSymmetric(const float* x, const float* h, unsigned n);
+
+    enum InstructionSet { SCALAR, SSE2, AVX2 };
+    // Use these kernels instead of the best the CPU has (as FIRFilterTest does, to check each.)
+    // Returns false, and changes nothing, if this CPU or build lacks them. Not thread safe.
+    static bool Use(InstructionSet is);
+};
+
 // Finite Impulse Response filter.
+// The history is kept twice over, end to end, so the most recent len samples are always
+// contiguous, oldest first, starting at m_lastIndex. Sample_t may be double or float.
+// Coefficients that are symmetric (as all linear phase designs are) are detected, and
+// only half of them are kept.
 
- class CFIRFilter
+template <class Sample_t>
+ class CFIRFilterT
     {
     public:
-        CFIRFilter() 
-        : m_lastIndex(0)
-        , m_pCoef(&Dummy)
-        , m_history(1, 0.f)
+        CFIRFilterT()
+        : m_len(1)
+        , m_lastIndex(0)
+        , m_decimatePhase(0)
+        , m_symmetric(true)
+        , m_coef(1, 1)
+        , m_history(2, 0)
         {}
 
-        CFIRFilter(unsigned len, const FilterCoeficient_t *pCoef) 
+        CFIRFilterT(unsigned len, const FilterCoeficient_t *pCoef)
+        : CFIRFilterT()
         {
             setFilterDefinition(len, pCoef);
         }
 
-        void applySample(double b)
+        void applySample(Sample_t b)
         {
-            m_history[m_lastIndex++] = b;
-            if (m_lastIndex >= m_history.size())
+            m_history[m_lastIndex] = b;
+            m_history[m_lastIndex + m_len] = b;
+            if (++m_lastIndex >= m_len)
                 m_lastIndex = 0;
         };
 
-        double value() const
+        Sample_t value() const
+        {   // coefficient zero goes with the oldest sample
+            if (m_symmetric)
+                return FIRKernels::DotSymmetric(&m_history[m_lastIndex], &m_coef[0], m_len);
+            return FIRKernels::Dot(&m_history[m_lastIndex], &m_coef[0], m_len);
+        }
+
+        // Push numSamples samples from in[]. After every decimate'th one (counting across calls),
+        // write the filter's value to out[]. Returns the number written, which is at
+        // most numSamples / decimate + 1. A decimate of one gives the full rate output.
+        unsigned applyBlock(const Sample_t* in, unsigned numSamples, Sample_t* out, unsigned decimate = 1)
         {
-            const unsigned len = static_cast<unsigned>(m_history.size());
-            unsigned j = m_lastIndex;
-            const FilterCoeficient_t *pCoef = m_pCoef;
-            double v = 0;
-            const double *pHist = &m_history[0];
-            for (unsigned i = 0; i < len; i++)
+            unsigned numOut = 0;
+            for (unsigned i = 0; i < numSamples; i++)
             {
-                v += pHist[j++] * *pCoef++;
-                if (j >= len) j = 0;
+                applySample(in[i]);
+                if (++m_decimatePhase < decimate)
+                    continue;
+                m_decimatePhase = 0;
+                out[numOut++] = value();
             }
-            return v;
+            return numOut;
         }
 
         void setFilterDefinition(unsigned len, const FilterCoeficient_t *pCoef)
         {
             if (len == 0)
                 return; // not allowed
-            if (len != m_history.size())
-            {   
-                m_history.resize(len);
-                memset(&m_history[0], 0, sizeof(float) * len);
+            if (len != m_len)
+            {
+                m_len = len;
+                m_history.assign(2 * len, 0);
                 m_lastIndex = 0;
             } // else keep the history for real time glitch reduction.
-            m_pCoef = pCoef;
+            m_symmetric = true;
+            for (unsigned i = 0; i < len / 2; i++)
+                if (pCoef[i] != pCoef[len - 1 - i])
+                    m_symmetric = false;
+            m_coef.assign(pCoef, pCoef + (m_symmetric ? (len + 1) / 2 : len));
         }
 
+        unsigned get_length() const { return m_len; }
+        bool get_isSymmetric() const { return m_symmetric; }
+
         // diagnostic
         double Rms() const {
             double v = 0;
-            for (auto e : m_history)
-                v += e * e;
+            for (unsigned i = 0; i < m_len; i++)
+                v += m_history[i] * m_history[i];
             v = sqrt(v);
-            v /= m_history.size();
+            v /= m_len;
             return v;
         }
 
         double FabsAvg() const {
             double v = 0;
-            for (auto e : m_history)
-                v += fabs(e);
-            v /= m_history.size();
+            for (unsigned i = 0; i < m_len; i++)
+                v += fabs(m_history[i]);
+            v /= m_len;
             return v;
         }
 
     protected:
-        static  const FilterCoeficient_t Dummy;
-
+        unsigned m_len;
         unsigned m_lastIndex;
-        const FilterCoeficient_t *m_pCoef;
-        std::vector<double> m_history;
+        unsigned m_decimatePhase;
+        bool m_symmetric;
+        std::vector<Sample_t> m_coef; // only the first half, if m_symmetric
+        std::vector<Sample_t> m_history;
     };
+
+typedef CFIRFilterT<double> CFIRFilter;
+typedef CFIRFilterT<float> CFIRFilterFloat;
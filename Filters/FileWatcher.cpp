@@ -0,0 +1,95 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#include "FileWatcher.h"
+#include <chrono>
+#include <thread>
+#if defined(_WIN32)
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+CFileWatcher::CFileWatcher()
+    : m_change(INVALID_HANDLE_VALUE)
+{}
+
+bool CFileWatcher::Open(const std::string& fileName)
+{
+    Close();
+    // the notification is for the folder. any file in it being written wakes Wait
+    std::string folder = ".";
+    auto slash = fileName.find_last_of("\\/");
+    if (slash != fileName.npos)
+        folder = fileName.substr(0, slash + 1);
+    m_change = FindFirstChangeNotificationA(folder.c_str(), FALSE,
+        FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+    return m_change != INVALID_HANDLE_VALUE;
+}
+
+void CFileWatcher::Close()
+{
+    if (m_change != INVALID_HANDLE_VALUE)
+        FindCloseChangeNotification(m_change);
+    m_change = INVALID_HANDLE_VALUE;
+}
+
+void CFileWatcher::Wait(unsigned milliseconds)
+{
+    if (m_change == INVALID_HANDLE_VALUE)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+        return;
+    }
+    if (WaitForSingleObject(m_change, milliseconds) == WAIT_OBJECT_0)
+        FindNextChangeNotification(m_change);
+}
+#else
+CFileWatcher::CFileWatcher()
+    : m_fd(-1)
+{}
+
+bool CFileWatcher::Open(const std::string& fileName)
+{
+    Close();
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0)
+        return false;
+    if (inotify_add_watch(m_fd, fileName.c_str(), IN_MODIFY | IN_CLOSE_WRITE) < 0)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void CFileWatcher::Close()
+{
+    if (m_fd >= 0)
+        close(m_fd);
+    m_fd = -1;
+}
+
+void CFileWatcher::Wait(unsigned milliseconds)
+{
+    if (m_fd < 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+        return;
+    }
+    struct pollfd pfd = { m_fd, POLLIN, 0 };
+    if (poll(&pfd, 1, static_cast<int>(milliseconds)) > 0)
+    {   // a write can make any number of events. one wake is enough for all of them
+        char buf[4096];
+        while (read(m_fd, buf, sizeof(buf)) > 0)
+            ;
+    }
+}
+#endif
+
+CFileWatcher::~CFileWatcher()
+{
+    Close();
+}
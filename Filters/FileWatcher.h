@@ -0,0 +1,29 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#pragma once
+#include <string>
+
+// Wait for a file that a recorder is still writing to change. inotify on Linux and a change
+// notification on its folder on Windows. Where neither can be had, Wait just sleeps, so the
+// caller ends up polling.
+class CFileWatcher
+{
+public:
+    CFileWatcher();
+    ~CFileWatcher();
+
+    // returns false if the file can't be watched. Wait still works, by sleeping.
+    bool Open(const std::string& fileName);
+    void Close();
+
+    // Returns when the file might have changed, or after milliseconds, whichever is first.
+    void Wait(unsigned milliseconds);
+
+private:
+    CFileWatcher(const CFileWatcher&) = delete;
+    CFileWatcher& operator = (const CFileWatcher&) = delete;
+#if defined(_WIN32)
+    void* m_change;
+#else
+    int m_fd;
+#endif
+};
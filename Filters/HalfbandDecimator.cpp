@@ -0,0 +1,137 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#include "HalfbandDecimator.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    const double Pi = 3.14159265358979323846264338;
+
+    // zeroth order modified Bessel function of the first kind, for the Kaiser window
+    double I0(double x)
+    {
+        double sum = 1;
+        double term = 1;
+        for (int k = 1; k < 50; k++)
+        {
+            term *= (x / (2 * k)) * (x / (2 * k));
+            sum += term;
+            if (term < sum * 1e-17)
+                break;
+        }
+        return sum;
+    }
+
+    double KaiserBeta(double stopbandDb)
+    {
+        if (stopbandDb > 50)
+            return 0.1102 * (stopbandDb - 8.7);
+        if (stopbandDb >= 21)
+            return 0.5842 * pow(stopbandDb - 21, 0.4) + 0.07886 * (stopbandDb - 21);
+        return 0;
+    }
+}
+
+CHalfbandDecimator::CHalfbandDecimator(unsigned numTaps, double stopbandDb)
+    : m_len(numTaps)
+    , m_lastIndex(0)
+    , m_phase(0)
+    , m_center(0.5)
+    , m_historyI(2 * numTaps, 0.)
+    , m_historyQ(2 * numTaps, 0.)
+{
+    if (numTaps < 3 || (numTaps % 4) != 3)
+        throw std::runtime_error("Halfband filter length must be of the form 4k+3");
+    // windowed sinc with its cutoff at a quarter of the sample rate:
+    //      h[n] = 0.5 * sinc(n/2) * w[n], n = -(L-1)/2 ... (L-1)/2
+    // which is zero for every even n other than zero.
+    const double beta = KaiserBeta(stopbandDb);
+    const int half = static_cast<int>(numTaps / 2);
+    std::vector<double> taps;
+    double sum = 0;
+    for (int n = -half; n <= half; n++)
+    {
+        double r = static_cast<double>(n) / half;
+        double w = I0(beta * sqrt(1 - r * r)) / I0(beta);
+        double h = (n == 0) ? 0.5 : sin(Pi * n / 2) / (Pi * n) * w;
+        taps.push_back(h);
+        sum += h;
+    }
+    // normalize for unity gain at DC
+    m_center = taps[half] / sum;
+    for (unsigned i = 0; i < numTaps; i += 2)
+        m_coef.push_back(taps[i] / sum);
+}
+
+unsigned CHalfbandDecimator::TapsFor(double passbandHz, double sampleRate, double stopbandDb)
+{
+    // Kaiser's estimate of the order.
+    double transition = (sampleRate / 2 - 2 * passbandHz) / sampleRate;
+    if (transition <= 0)
+        throw std::runtime_error("Halfband passband must be less than a quarter of the sample rate");
+    unsigned n = static_cast<unsigned>(ceil((stopbandDb - 8) / (2.285 * 2 * Pi * transition))) + 1;
+    // round up to 4k+3
+    while ((n % 4) != 3)
+        n += 1;
+    return n;
+}
+
+const double CCicDecimator::FIXED_POINT_SCALE = static_cast<double>(1 << 30);
+
+CCicDecimator::CCicDecimator(unsigned decimate, unsigned stages)
+    : m_decimate(decimate)
+    , m_stages(stages)
+    , m_phase(0)
+    , m_outputScale(1.0 / (FIXED_POINT_SCALE * pow(static_cast<double>(decimate), static_cast<int>(stages))))
+    , m_integratorI(stages, 0)
+    , m_integratorQ(stages, 0)
+    , m_combI(stages, 0)
+    , m_combQ(stages, 0)
+{}
+
+double CCicDecimator::Gain(double f) const
+{
+    if (f == 0)
+        return 1;
+    double g = sin(Pi * f * m_decimate) / (m_decimate * sin(Pi * f));
+    return pow(fabs(g), static_cast<int>(m_stages));
+}
+
+namespace {
+    const double HALFBAND_STOPBAND_DB = 80;
+    const unsigned CIC_DECIMATE = 4;
+    const unsigned CIC_STAGES = 4;
+}
+
+CDecimationChain::CDecimationChain(unsigned inputRate, unsigned outputRate, double passbandHz, bool useCic)
+    : m_firstOutputCenter(0)
+{
+    if (outputRate == 0 || (inputRate % outputRate) != 0)
+        throw std::runtime_error("Decimation chain requires an integer rate ratio");
+    unsigned ratio = inputRate / outputRate;
+    if ((ratio & (ratio - 1)) != 0)
+        throw std::runtime_error("Decimation chain requires a power of two rate ratio");
+    // The last stage carries the entire transition band, from passbandHz to its alias at
+    // outputRate - passbandHz. The earlier ones only need to reject what would alias onto
+    // that band.
+    const double protectHz = outputRate - passbandHz;
+    double rate = inputRate;
+    // A stage's output m comes from its input (decimate * m + decimate - 1), and is centered half its
+    // impulse response before that. Its inputs are themselves spacing * i + m_firstOutputCenter in input samples.
+    double spacing = 1;
+    if (useCic && ratio >= 2 * CIC_DECIMATE)
+    {
+        m_cic.reset(new CCicDecimator(CIC_DECIMATE, CIC_STAGES));
+        m_firstOutputCenter = CIC_DECIMATE - 1 - CIC_STAGES * (CIC_DECIMATE - 1) / 2.0;
+        spacing = CIC_DECIMATE;
+        rate /= CIC_DECIMATE;
+        ratio /= CIC_DECIMATE;
+    }
+    for (; ratio > 1; ratio /= 2, rate /= 2)
+    {
+        double edge = ratio == 2 ? passbandHz : protectHz;
+        unsigned numTaps = CHalfbandDecimator::TapsFor(edge, rate, HALFBAND_STOPBAND_DB);
+        m_stages.push_back(CHalfbandDecimator(numTaps, HALFBAND_STOPBAND_DB));
+        m_firstOutputCenter += spacing * (1 - (numTaps - 1) / 2.0);
+        spacing *= 2;
+    }
+}
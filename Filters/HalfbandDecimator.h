@@ -0,0 +1,145 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// Decimate-by-two lowpass whose transition band is centered on a quarter of
+// the input rate. Every other tap (except the center one) of such a filter is
+// zero, so only about half the taps are stored and multiplied, and an output is
+// computed only on every second input sample.
+// Operates on I and Q together.
+class CHalfbandDecimator
+{
+public:
+    // numTaps must be of the form 4k+3. The Kaiser window is designed for stopbandDb of attenuation.
+    CHalfbandDecimator(unsigned numTaps, double stopbandDb);
+
+    // The number of taps (of the form 4k+3) a halfband stage needs to keep
+    // everything from 0 to passbandHz and reject its alias at sampleRate/2 - passbandHz.
+    static unsigned TapsFor(double passbandHz, double sampleRate, double stopbandDb);
+
+    // returns true when outI/outQ are set to a decimated output
+    bool applySample(double inI, double inQ, double &outI, double &outQ)
+    {
+        m_historyI[m_lastIndex] = inI;
+        m_historyI[m_lastIndex + m_len] = inI;
+        m_historyQ[m_lastIndex] = inQ;
+        m_historyQ[m_lastIndex + m_len] = inQ;
+        if (++m_lastIndex >= m_len)
+            m_lastIndex = 0;
+        m_phase ^= 1;
+        if (m_phase != 0)
+            return false;
+        // history is doubled so the oldest sample is at m_lastIndex and the newest
+        // is at m_lastIndex + m_len - 1 with no wrap check.
+        const double *pI = &m_historyI[m_lastIndex];
+        const double *pQ = &m_historyQ[m_lastIndex];
+        double vI = m_center * pI[m_len / 2];
+        double vQ = m_center * pQ[m_len / 2];
+        const double *pCoef = &m_coef[0];
+        for (unsigned i = 0; i < m_len; i += 2)
+        {
+            vI += pI[i] * *pCoef;
+            vQ += pQ[i] * *pCoef++;
+        }
+        outI = vI;
+        outQ = vQ;
+        return true;
+    }
+
+    unsigned get_numTaps() const { return m_len; }
+
+protected:
+    unsigned m_len;
+    unsigned m_lastIndex;
+    unsigned m_phase;
+    double m_center;
+    std::vector<double> m_coef; // the nonzero taps other than the center, at even offsets
+    std::vector<double> m_historyI;
+    std::vector<double> m_historyQ;
+};
+
+// Cascaded Integrator Comb decimator. No multiplies at all, but its passband droops
+// so it is only suitable where the band of interest is a small fraction of the
+// output rate. The integrators run in wrapping 64 bit integer arithmetic,
+// which makes the output exact no matter how long it runs.
+class CCicDecimator
+{
+public:
+    CCicDecimator(unsigned decimate, unsigned stages);
+
+    bool applySample(double inI, double inQ, double &outI, double &outQ)
+    {
+        uint64_t vI = static_cast<uint64_t>(static_cast<int64_t>(inI * FIXED_POINT_SCALE));
+        uint64_t vQ = static_cast<uint64_t>(static_cast<int64_t>(inQ * FIXED_POINT_SCALE));
+        for (unsigned i = 0; i < m_stages; i++)
+        {
+            vI = (m_integratorI[i] += vI);
+            vQ = (m_integratorQ[i] += vQ);
+        }
+        if (++m_phase < m_decimate)
+            return false;
+        m_phase = 0;
+        for (unsigned i = 0; i < m_stages; i++)
+        {
+            uint64_t prevI = m_combI[i];
+            m_combI[i] = vI;
+            vI -= prevI;
+            uint64_t prevQ = m_combQ[i];
+            m_combQ[i] = vQ;
+            vQ -= prevQ;
+        }
+        outI = static_cast<int64_t>(vI) * m_outputScale;
+        outQ = static_cast<int64_t>(vQ) * m_outputScale;
+        return true;
+    }
+
+    unsigned get_decimate() const { return m_decimate; }
+
+    // The magnitude response relative to DC at frequency f (in units of the input rate)
+    double Gain(double f) const;
+
+protected:
+    static const double FIXED_POINT_SCALE;
+    unsigned m_decimate;
+    unsigned m_stages;
+    unsigned m_phase;
+    double m_outputScale;
+    std::vector<uint64_t> m_integratorI;
+    std::vector<uint64_t> m_integratorQ;
+    std::vector<uint64_t> m_combI;
+    std::vector<uint64_t> m_combQ;
+};
+
+// Reduce the sample rate by a power of two in a cascade of halfband stages,
+// optionally with a CIC stage in front. Each stage only has to protect
+// passbandHz from aliasing, so the early stages (which run at the highest rates)
+// are short and only the last one is sharp.
+class CDecimationChain
+{
+public:
+    CDecimationChain(unsigned inputRate, unsigned outputRate, double passbandHz, bool useCic);
+
+    bool applySample(double inI, double inQ, double &outI, double &outQ)
+    {
+        if (m_cic && !m_cic->applySample(inI, inQ, inI, inQ))
+            return false;
+        for (auto &s : m_stages)
+            if (!s.applySample(inI, inQ, inI, inQ))
+                return false;
+        outI = inI;
+        outQ = inQ;
+        return true;
+    }
+
+    // Output n is centered on input sample n * (inputRate / outputRate) + get_firstOutputCenter(),
+    // counting the first input as sample 0. It is negative: the filters' group delay, less
+    // the inputs it takes to make an output.
+    double get_firstOutputCenter() const { return m_firstOutputCenter; }
+
+protected:
+    double m_firstOutputCenter;
+    std::unique_ptr<CCicDecimator> m_cic;
+    std::vector<CHalfbandDecimator> m_stages;
+};
@@ -0,0 +1,181 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#include "MappedFile.h"
+#if defined(_WIN32)
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+CMappedFile::CMappedFile()
+    : m_file(INVALID_HANDLE_VALUE)
+    , m_mapping(nullptr)
+    , m_fileSize(0)
+    , m_granularity(0)
+    , m_view(nullptr)
+    , m_viewLength(0)
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    m_granularity = si.dwAllocationGranularity;
+}
+
+bool CMappedFile::Open(const std::string& fileName)
+{
+    Close();
+    m_file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+    m_fileSize = static_cast<uint64_t>(size.QuadPart);
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping == nullptr)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void CMappedFile::Close()
+{
+    UnmapView();
+    if (m_mapping != nullptr)
+        CloseHandle(m_mapping);
+    m_mapping = nullptr;
+    if (m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+    m_file = INVALID_HANDLE_VALUE;
+    m_fileSize = 0;
+}
+
+unsigned char* CMappedFile::MapView(uint64_t offset, size_t length)
+{
+    UnmapView();
+    if (m_mapping == nullptr || length == 0 || offset + length > m_fileSize)
+        return nullptr;
+    uint64_t aligned = offset - offset % m_granularity;
+    size_t viewLength = static_cast<size_t>(offset - aligned) + length;
+    m_view = MapViewOfFile(m_mapping, FILE_MAP_COPY, static_cast<DWORD>(aligned >> 32),
+        static_cast<DWORD>(aligned), viewLength);
+    if (m_view == nullptr)
+        return nullptr;
+    m_viewLength = viewLength;
+    return static_cast<unsigned char*>(m_view) + (offset - aligned);
+}
+
+void CMappedFile::UnmapView()
+{
+    if (m_view != nullptr)
+        UnmapViewOfFile(m_view);
+    m_view = nullptr;
+    m_viewLength = 0;
+}
+
+void CMappedFile::Prefetch(uint64_t, size_t)
+{}  // FILE_FLAG_SEQUENTIAL_SCAN already has the cache manager reading ahead
+
+bool CMappedFile::Refresh()
+{
+    LARGE_INTEGER size;
+    if (m_mapping == nullptr || !GetFileSizeEx(m_file, &size) || static_cast<uint64_t>(size.QuadPart) <= m_fileSize)
+        return false;
+    // a mapping is the size the file was when it was created
+    UnmapView();
+    HANDLE mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+        return false;
+    CloseHandle(m_mapping);
+    m_mapping = mapping;
+    m_fileSize = static_cast<uint64_t>(size.QuadPart);
+    return true;
+}
+#else
+CMappedFile::CMappedFile()
+    : m_fd(-1)
+    , m_fileSize(0)
+    , m_granularity(static_cast<uint64_t>(sysconf(_SC_PAGESIZE)))
+    , m_view(nullptr)
+    , m_viewLength(0)
+{}
+
+bool CMappedFile::Open(const std::string& fileName)
+{
+    Close();
+    m_fd = open(fileName.c_str(), O_RDONLY);
+    if (m_fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+    {
+        Close();
+        return false;
+    }
+    m_fileSize = static_cast<uint64_t>(st.st_size);
+    return true;
+}
+
+void CMappedFile::Close()
+{
+    UnmapView();
+    if (m_fd >= 0)
+        close(m_fd);
+    m_fd = -1;
+    m_fileSize = 0;
+}
+
+unsigned char* CMappedFile::MapView(uint64_t offset, size_t length)
+{
+    UnmapView();
+    if (m_fd < 0 || length == 0 || offset + length > m_fileSize)
+        return nullptr;
+    uint64_t aligned = offset - offset % m_granularity;
+    size_t viewLength = static_cast<size_t>(offset - aligned) + length;
+    void* view = mmap(nullptr, viewLength, PROT_READ | PROT_WRITE, MAP_PRIVATE, m_fd, static_cast<off_t>(aligned));
+    if (view == MAP_FAILED)
+        return nullptr;
+    madvise(view, viewLength, MADV_SEQUENTIAL);
+    m_view = view;
+    m_viewLength = viewLength;
+    return static_cast<unsigned char*>(m_view) + (offset - aligned);
+}
+
+void CMappedFile::UnmapView()
+{   // the consumer is done with these pages.
+    if (m_view != nullptr)
+        munmap(m_view, m_viewLength);
+    m_view = nullptr;
+    m_viewLength = 0;
+}
+
+void CMappedFile::Prefetch(uint64_t offset, size_t length)
+{
+    if (m_fd >= 0)
+        posix_fadvise(m_fd, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+}
+
+bool CMappedFile::Refresh()
+{
+    struct stat st;
+    if (m_fd < 0 || fstat(m_fd, &st) != 0 || static_cast<uint64_t>(st.st_size) <= m_fileSize)
+        return false;
+    UnmapView();
+    m_fileSize = static_cast<uint64_t>(st.st_size);
+    return true;
+}
+#endif
+
+CMappedFile::~CMappedFile()
+{
+    Close();
+}
@@ -0,0 +1,47 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Read a file through a memory mapping, one view at a time. The views are copy-on-write,
+// so a consumer that scribbles on one does not change the file.
+class CMappedFile
+{
+public:
+    CMappedFile();
+    ~CMappedFile();
+
+    // returns false if the file can't be opened, or the OS can't map it.
+    bool Open(const std::string& fileName);
+    void Close();
+
+    // Unmaps the previous view, if any, and maps length bytes starting at offset,
+    // which need not be aligned. Returns the address of the byte at offset, or nullptr.
+    // The view is advised for sequential access.
+    unsigned char* MapView(uint64_t offset, size_t length);
+    void UnmapView();
+
+    // Hint that length bytes at offset will be mapped next.
+    void Prefetch(uint64_t offset, size_t length);
+
+    uint64_t get_fileSize() const { return m_fileSize; }
+
+    // Take in the new size of a file that is still being written. Unmaps the view.
+    // Returns true if the file grew.
+    bool Refresh();
+
+private:
+    CMappedFile(const CMappedFile&) = delete;
+    CMappedFile& operator = (const CMappedFile&) = delete;
+#if defined(_WIN32)
+    void* m_file;
+    void* m_mapping;
+#else
+    int m_fd;
+#endif
+    uint64_t m_fileSize;
+    uint64_t m_granularity;
+    void* m_view;
+    size_t m_viewLength;
+};
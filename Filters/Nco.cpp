@@ -0,0 +1,121 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#include "Nco.h"
+#include <cmath>
+
+namespace {
+    const double TwoPi = 2. * 3.14159265358979323846264338;
+    const double TWO_TO_64 = 18446744073709551616.0;
+    // Frames between recomputing the phasor from the phase. The rotation's rounding
+    // error grows with each step, but only reaches 1e-13 or so by then.
+    const unsigned STEPS_PER_ANCHOR = 256;
+}
+
+CNco::CNco(double framesPerSecond)
+    : m_framesPerSecond(framesPerSecond)
+    , m_frequency(0)
+    , m_phase(0)
+    , m_increment(0)
+    , m_step(1, 0)
+    , m_frame(0)
+    , m_phasor(1, 0)
+    , m_phasorValid(false)
+{}
+
+void CNco::SetFrequency(double hz)
+{
+    m_frequency = hz;
+    double cycles = hz / m_framesPerSecond;
+    cycles -= floor(cycles); // 0 <= cycles < 1, as a 64 bit fraction wraps negative to positive
+    double scaled = ldexp(cycles, 64);
+    m_increment = scaled >= TWO_TO_64 ? 0 : static_cast<uint64_t>(scaled);
+    m_step = std::polar(1.0, toRadians(m_increment));
+    m_phasorValid = false;
+}
+
+void CNco::SetPhase(double radians)
+{
+    double cycles = radians / TwoPi;
+    cycles -= floor(cycles);
+    double scaled = ldexp(cycles, 64);
+    m_phase = scaled >= TWO_TO_64 ? 0 : static_cast<uint64_t>(scaled);
+    m_frame = 0;
+    m_phasorValid = false;
+}
+
+void CNco::Skip(int64_t numFrames)
+{
+    m_phase += m_increment * static_cast<uint64_t>(numFrames);
+    m_frame += static_cast<uint64_t>(numFrames);
+    m_phasorValid = false;
+}
+
+double CNco::get_phase() const
+{
+    return toRadians(m_phase);
+}
+
+std::complex<double> CNco::Value() const
+{
+    return std::polar(1.0, toRadians(m_phase));
+}
+
+void CNco::rotate(double& re, double& im, std::complex<double> step, unsigned numSteps, double* cosOut, double* sinOut)
+{
+    const double stepRe = step.real();
+    const double stepIm = step.imag();
+    for (unsigned i = 0; i < numSteps; i++)
+    {
+        if (cosOut)
+        {
+            cosOut[i] = re;
+            sinOut[i] = im;
+        }
+        double nextRe = re * stepRe - im * stepIm;
+        im = re * stepIm + im * stepRe;
+        re = nextRe;
+    }
+}
+
+void CNco::anchor()
+{   // Start at the last anchor before this frame and rotate forward, exactly as Generate would have
+    // had it run from there, so the phasor doesn't depend on how this frame was reached.
+    const unsigned sinceAnchor = static_cast<unsigned>(m_frame % STEPS_PER_ANCHOR);
+    std::complex<double> v = std::polar(1.0, toRadians(m_phase - m_increment * sinceAnchor));
+    double re = v.real();
+    double im = v.imag();
+    rotate(re, im, m_step, sinceAnchor, nullptr, nullptr);
+    m_phasor = std::complex<double>(re, im);
+    m_phasorValid = true;
+}
+
+void CNco::Generate(double* cosOut, double* sinOut, unsigned numFrames)
+{
+    if (!m_phasorValid)
+        anchor();
+    while (numFrames > 0)
+    {
+        const unsigned toAnchor = STEPS_PER_ANCHOR - static_cast<unsigned>(m_frame % STEPS_PER_ANCHOR);
+        const unsigned n = numFrames < toAnchor ? numFrames : toAnchor;
+        double re = m_phasor.real();
+        double im = m_phasor.imag();
+        rotate(re, im, m_step, n, cosOut, sinOut);
+        m_phase += m_increment * n;
+        m_frame += n;
+        m_phasor = n == toAnchor ? Value() : std::complex<double>(re, im);
+        cosOut += n;
+        sinOut += n;
+        numFrames -= n;
+    }
+}
+
+double CNco::TablePhase(double hz)
+{
+    if (hz == 0)
+        return TwoPi / 8;
+    return hz < 0 ? -TwoPi / 4 : TwoPi / 4;
+}
+
+double CNco::toRadians(uint64_t phase)
+{   // as signed, so the result is -pi to pi
+    return ldexp(static_cast<double>(static_cast<int64_t>(phase)), -64) * TwoPi;
+}
@@ -0,0 +1,52 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#pragma once
+#include <complex>
+#include <cstdint>
+
+// Numerically controlled oscillator: exp(j * phase), with the phase advancing by 2 pi * frequency / framesPerSecond
+// each frame. The phase is a 64 bit fraction of a cycle, so the frequency resolution is far below 1Hz, and the
+// phase any number of frames ahead is one multiply away. The output is made by rotating a phasor that is
+// recomputed from the exact phase every 256 frames, counted from the last SetPhase. Those anchors do not move
+// with where Generate calls or Skips begin and end, so the output is bit for bit the same however the
+// frames are split among calls (or threads.)
+class CNco
+{
+public:
+    CNco(double framesPerSecond);
+
+    // hz may be negative, and need not be a whole number. The phase is not changed, so
+    // retuning a running oscillator is glitch free, and takes constant time.
+    void SetFrequency(double hz);
+    double get_frequency() const { return m_frequency; }
+
+    void SetPhase(double radians);
+    double get_phase() const; // radians, -pi to pi
+
+    // Advance (or, for negative, back up) the phase by numFrames.
+    void Skip(int64_t numFrames);
+
+    // The current output, without advancing.
+    std::complex<double> Value() const;
+
+    // Writes the next numFrames outputs, real parts to cosOut and imaginary to sinOut, and advances past them.
+    void Generate(double* cosOut, double* sinOut, unsigned numFrames);
+
+    // The sine/cosine tables the mixers used before CNco multiplied by A * exp(-j 2 pi hz n / framesPerSecond),
+    // where A is j for positive hz, -j for negative, and (1+j)/sqrt(2) for zero. This is the angle of A, so
+    // a CNco started there, at frequency -hz, makes the same output the tables did.
+    static double TablePhase(double hz);
+
+private:
+    static double toRadians(uint64_t phase);
+    // Advances re + j im by numSteps of step, writing each value before it is advanced, if cosOut is not null.
+    static void rotate(double& re, double& im, std::complex<double> step, unsigned numSteps, double* cosOut, double* sinOut);
+    void anchor();
+    const double m_framesPerSecond;
+    double m_frequency;
+    uint64_t m_phase;
+    uint64_t m_increment;
+    std::complex<double> m_step; // exp(j * 2 pi * frequency / framesPerSecond)
+    uint64_t m_frame; // since SetPhase, and only used modulo the anchor spacing
+    std::complex<double> m_phasor; // Generate's next output
+    bool m_phasorValid;
+};
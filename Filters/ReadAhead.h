@@ -0,0 +1,179 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#pragma once
+#include <istream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+
+// Reads a byte range of a stream on a background thread into a bounded ring of
+// buffers, so the reads overlap whatever the consumer does with the previous buffers.
+// Once the read ahead is started, only its thread may touch the stream.
+class CReadAhead
+{
+public:
+    struct Stats {
+        Stats() : buffersRead(0), consumerStalls(0), readerStalls(0), queueDepth(0), maxQueueDepth(0) {}
+        uint64_t buffersRead;
+        uint64_t consumerStalls; // Next had to wait for the reader: I/O bound
+        uint64_t readerStalls; // the ring was full: compute bound
+        unsigned queueDepth; // filled buffers waiting for the consumer
+        unsigned maxQueueDepth;
+    };
+
+    // bufferBytes should be a multiple of the frame size, so no frame is split between buffers.
+    CReadAhead(std::istream& input, unsigned numBuffers, size_t bufferBytes)
+        : m_input(input)
+        , m_bufferBytes(bufferBytes)
+        , m_slots(std::max(2u, numBuffers))
+        , m_head(0)
+        , m_count(0)
+        , m_holding(false)
+        , m_epoch(0)
+        , m_position(0)
+        , m_byteCount(0)
+        , m_readerDone(true)
+        , m_stop(false)
+    {
+        for (auto& s : m_slots)
+        {   // page aligned
+            s.storage.resize(m_bufferBytes + BUFFER_ALIGNMENT);
+            auto addr = reinterpret_cast<uintptr_t>(&s.storage[0]);
+            s.data = &s.storage[0] + (BUFFER_ALIGNMENT - addr % BUFFER_ALIGNMENT) % BUFFER_ALIGNMENT;
+        }
+        m_thread = std::thread(std::bind(&CReadAhead::thread, this));
+    }
+
+    ~CReadAhead()
+    {
+        {
+            lock_t l(m_mutex);
+            m_stop = true;
+            m_cond.notify_all();
+        }
+        m_thread.join();
+    }
+
+    // Discard whatever is queued and start reading byteCount bytes at position.
+    // The buffer from the last Next stays valid until the next Next.
+    void Start(std::streampos position, uint64_t byteCount)
+    {
+        lock_t l(m_mutex);
+        m_epoch += 1;
+        m_position = position;
+        m_byteCount = byteCount;
+        m_readerDone = false;
+        m_count = m_holding ? 1 : 0;
+        m_cond.notify_all();
+    }
+
+    // Returns the next buffer's byte count and sets p to it, or returns zero at the end
+    // of the range. Hands the previous buffer back to the reader.
+    size_t Next(unsigned char*& p)
+    {
+        lock_t l(m_mutex);
+        if (m_holding)
+        {
+            m_holding = false;
+            m_head = (m_head + 1) % static_cast<unsigned>(m_slots.size());
+            m_count -= 1;
+            m_cond.notify_all();
+        }
+        if (m_count == 0 && !m_readerDone)
+        {
+            m_stats.consumerStalls += 1;
+            while (m_count == 0 && !m_readerDone)
+                m_cond.wait(l);
+        }
+        if (m_count == 0)
+            return 0;
+        m_holding = true;
+        p = m_slots[m_head].data;
+        return m_slots[m_head].bytes;
+    }
+
+    Stats get_stats() const
+    {
+        lock_t l(m_mutex);
+        Stats ret = m_stats;
+        ret.queueDepth = m_count - (m_holding ? 1 : 0);
+        return ret;
+    }
+
+private:
+    enum { BUFFER_ALIGNMENT = 4096 };
+    typedef std::unique_lock<std::mutex> lock_t;
+    struct Slot {
+        Slot() : data(nullptr), bytes(0) {}
+        std::vector<unsigned char> storage;
+        unsigned char* data;
+        size_t bytes;
+    };
+
+    void thread()
+    {
+        lock_t l(m_mutex);
+        uint64_t epoch = 0; // so the first Start is seen, even if it came before we got here
+        uint64_t remaining = 0;
+        while (!m_stop)
+        {
+            if (epoch != m_epoch)
+            {   // (re)started
+                epoch = m_epoch;
+                remaining = m_byteCount;
+                m_input.clear();
+                m_input.seekg(m_position);
+            }
+            if (m_readerDone || m_count == m_slots.size())
+            {
+                if (!m_readerDone)
+                    m_stats.readerStalls += 1;
+                m_cond.wait(l);
+                continue;
+            }
+            Slot& slot = m_slots[(m_head + m_count) % m_slots.size()];
+            size_t toRead = static_cast<size_t>(std::min<uint64_t>(m_bufferBytes, remaining));
+            l.unlock();
+            size_t bytes = 0;
+            if (toRead > 0)
+            {
+                m_input.read(reinterpret_cast<char*>(slot.data), static_cast<std::streamsize>(toRead));
+                bytes = static_cast<size_t>(m_input.gcount());
+            }
+            l.lock();
+            if (epoch != m_epoch)
+                continue; // restarted while we were reading. drop it.
+            if (bytes == 0)
+            {
+                m_readerDone = true;
+                m_cond.notify_all();
+                continue;
+            }
+            remaining -= bytes;
+            slot.bytes = bytes;
+            m_count += 1;
+            m_stats.buffersRead += 1;
+            m_stats.maxQueueDepth = std::max(m_stats.maxQueueDepth, m_count);
+            m_cond.notify_all();
+        }
+    }
+
+    std::istream& m_input;
+    const size_t m_bufferBytes;
+    std::vector<Slot> m_slots;
+    unsigned m_head; // the next one for the consumer
+    unsigned m_count; // filled, including the one the consumer holds
+    bool m_holding;
+    uint64_t m_epoch;
+    std::streampos m_position;
+    uint64_t m_byteCount;
+    bool m_readerDone;
+    bool m_stop;
+    Stats m_stats;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+};
@@ -1,17 +1,40 @@
 /* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
 #pragma once
-#include <fstream>
+#include <istream>
+#include <sstream>
+#include <limits>
 #include <functional>
 #include <vector>
 #include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "MappedFile.h"
+#include "ReadAhead.h"
+
+// Reads the WAVE files of a 32 bit RIFF container, and of its 64 bit successors RF64 (EBU Tech 3306)
+// and Sony Wave64, with frame numbers and offsets in 64 bits in any case.
+// The input can be a stream that can't seek, like a pipe. It is then read only in order: ProcessChunks
+// reads it as it comes, and SeekToFrameNumber can only skip forward.
 class RiffReader {
 public:
-    typedef std::function<void(const char *, unsigned, std::ifstream &)> RiffChunkFcn_t;
+    typedef std::function<void(const char *, unsigned, std::istream &)> RiffChunkFcn_t;
     typedef std::function<bool(unsigned char *, unsigned)> DataChunkFcn_t;
     typedef std::function<bool()> AtEndFcn_t;
 
-    RiffReader(std::ifstream& instream)
-        : format(0)
+    enum Container { RIFF, RF64, WAVE64 };
+
+    RiffReader(std::istream& instream)
+        : seekable(true)
+        , streamBytes(0)
+        , container(RIFF)
+        , ds64DataSize(0)
+        , declaredDataSize(0)
+        , dataChunkGrowing(false)
+        , dataChunkSizeKnown(true)
+        , format(0)
         , numChannels(0)
         , sampleRate(0)
         , byteRate(0)
@@ -19,34 +42,81 @@ public:
         , bitsPerSample(0)
         , dataChunkSize(0)
         , inputFile(instream)
+        , mappedFrame(0)
+        , readAheadBuffers(0)
+        , readAheadBytes(0)
+        , readAheadFrame(0)
     { }
 
+    // Read the frames of 'data' through a memory mapping of fileName (which must be the file 
+    // the istream has open) instead of through the istream. The DataChunkFcn_t is then handed
+    // large spans straight out of the mapping, and each is unmapped once it returns.
+    // Returns false if the file can't be mapped, in which case the istream is used as before.
+    bool MapFile(const std::string& fileName)
+    {
+        std::unique_ptr<CMappedFile> m(new CMappedFile());
+        if (!m->Open(fileName))
+            return false;
+        mappedFile = std::move(m);
+        return true;
+    }
+
+    // Read the frames of 'data' through the istream on a background thread, up to numBuffers
+    // of about bufferBytes each ahead of the DataChunkFcn_t. (Not used if MapFile succeeded.)
+    void ReadAhead(unsigned numBuffers, unsigned bufferBytes)
+    {
+        readAheadBuffers = numBuffers;
+        readAheadBytes = bufferBytes;
+    }
+
+    CReadAhead::Stats get_readAheadStats() const
+    {
+        if (readAhead)
+            return readAhead->get_stats();
+        return CReadAhead::Stats();
+    }
+
+    // Sony Wave64 names its chunks with 16 byte GUIDs instead of four character codes. Those of the 
+    // standard chunks start with the four character code, and all but 'riff' end the same.
+    static void Wave64Guid(const char *fourcc, unsigned char guid[16])
+    {
+        static const unsigned char riffSuffix[12] = { 0x2E, 0x91, 0xCF, 0x11, 0xA5, 0xD6, 0x28, 0xDB, 0x04, 0xC1, 0x00, 0x00 };
+        static const unsigned char suffix[12] = { 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A };
+        memcpy(guid, fourcc, 4);
+        memcpy(guid + 4, strncmp(fourcc, "riff", 4) == 0 ? riffSuffix : suffix, 12);
+    }
+
     void ParseHeader()
     {
-        std::vector<char> buf(4);
-        inputFile.read(&buf[0], buf.size());
-        if (strncmp(&buf[0], "RIFF", buf.size()) != 0)
+        seekable = inputFile.tellg() != std::streampos(-1);
+        std::vector<char> buf(16);
+        inputFile.read(&buf[0], 4);
+        if (strncmp(&buf[0], "RIFF", 4) == 0)
+            container = RIFF;
+        else if (strncmp(&buf[0], "RF64", 4) == 0)
+            container = RF64;
+        else if (strncmp(&buf[0], "riff", 4) == 0 && readWave64Guid("riff", buf))
+            container = WAVE64;
+        else
             throw std::runtime_error("Input file missing RIFF header");
-        uint32_t chunksize(0);
-        inputFile.read(&buf[0], buf.size()); // entire file size
-        for (int i = 3; i >= 0; i -= 1)
-        {
-            chunksize <<= 8;
-            chunksize |= static_cast<unsigned char>(buf[i]);
-        }
-        inputFile.read(&buf[0], buf.size());
-        if (strncmp(&buf[0], "WAVE", buf.size()) != 0)
+        readLittleEndian(container == WAVE64 ? 8 : 4); // entire file size
+        const char* wave = container == WAVE64 ? "wave" : "WAVE";
+        inputFile.read(&buf[0], 4);
+        if (strncmp(&buf[0], wave, 4) != 0 || (container == WAVE64 && !readWave64Guid(wave, buf)))
             throw std::runtime_error("Input file missing WAVE header");
-        inputFile.read(&buf[0], buf.size());
-        if (strncmp(&buf[0], "fmt ", buf.size()) != 0)
-            throw std::runtime_error("Input file missing fmt header");
-        chunksize = 0;
-        inputFile.read(&buf[0], buf.size()); // size of fmt
-        for (int i = 3; i >= 0; i -= 1)
-        {
-            chunksize <<= 8;
-            chunksize |= static_cast<unsigned char>(buf[i]);
+        uint64_t chunksize(0);
+        readChunkHeader(&buf[0], chunksize);
+        if (container == RF64)
+        {   // the 64 bit sizes of RIFF and data, whose 32 bit sizes are 0xFFFFFFFF
+            if (strncmp(&buf[0], "ds64", 4) != 0 || chunksize < 16)
+                throw std::runtime_error("Input file missing ds64 header");
+            readLittleEndian(8); // RIFF size
+            ds64DataSize = readLittleEndian(8);
+            skip(chunksize - 16);
+            readChunkHeader(&buf[0], chunksize);
         }
+        if (strncmp(&buf[0], "fmt ", 4) != 0)
+            throw std::runtime_error("Input file missing fmt header");
 
         inputFile.read(&buf[0], 2);
         format = (static_cast<unsigned char>(buf[1]) << 8) | static_cast<unsigned char>(buf[0]);
@@ -54,19 +124,8 @@ public:
         inputFile.read(&buf[0], 2);
         numChannels = (static_cast<unsigned char>(buf[1]) << 8) | static_cast<unsigned char>(buf[0]);
 
-        inputFile.read(&buf[0], buf.size());
-        for (int i = 3; i >= 0; i -= 1)
-        {
-            sampleRate <<= 8;
-            sampleRate |= static_cast<unsigned char>(buf[i]);
-        }
-
-        inputFile.read(&buf[0], buf.size());
-        for (int i = 3; i >= 0; i -= 1)
-        {
-            byteRate <<= 8;
-            byteRate |= static_cast<unsigned char>(buf[i]);
-        }
+        sampleRate = static_cast<uint32_t>(readLittleEndian(4));
+        byteRate = static_cast<uint32_t>(readLittleEndian(4));
 
         inputFile.read(&buf[0], 2);
         blockAlign = (static_cast<unsigned char>(buf[1]) << 8) | static_cast<unsigned char>(buf[0]);
@@ -74,88 +133,237 @@ public:
         inputFile.read(&buf[0], 2);
         bitsPerSample = (static_cast<unsigned char>(buf[1]) << 8) | static_cast<unsigned char>(buf[0]);
 
-        chunksize -= 16;
-        while (chunksize-- > 0)
-            inputFile.read(&buf[0], 1);
+        skip(chunksize - 16);
     }
     
-    void ProcessChunks(const DataChunkFcn_t& dataFcn, const RiffChunkFcn_t &chunkFcn = RiffChunkFcn_t(),
-            const AtEndFcn_t &atEnd = AtEndFcn_t())
+    // Skip (calling chunkFcn for) the chunks ahead of 'data', and leave the input positioned 
+    // at the first frame of 'data'. Returns false if there is no 'data' chunk.
+    bool FindDataChunk(const RiffChunkFcn_t &chunkFcn = RiffChunkFcn_t())
     {
-        std::vector<char> buf(4);
         std::vector<char> chunkTag(4);
         for (; !inputFile.eof();)
         {
-            bool skip = false;
-            inputFile.read(&chunkTag[0], chunkTag.size());
-            if (inputFile.eof())
+            uint64_t chunksize(0);
+            if (!readChunkHeader(&chunkTag[0], chunksize))
                 break;
-            if (strncmp(&chunkTag[0], "data", chunkTag.size()) != 0)
-                skip = true;
-            uint32_t chunksize(0);
-            inputFile.read(&buf[0], buf.size()); // entire file size
-            for (int i = 3; i >= 0; i -= 1)
-            {
-                chunksize <<= 8;
-                chunksize |= static_cast<unsigned char>(buf[i]);
+            if (strncmp(&chunkTag[0], "data", chunkTag.size()) != 0 && !seekable)
+            {   // can't come back to the end of the chunk after chunkFcn, so it gets a copy
+                std::string chunk(static_cast<size_t>(chunksize + padding(chunksize)), '\0');
+                if (!chunk.empty())
+                    inputFile.read(&chunk[0], chunk.size());
+                if (chunkFcn)
+                {
+                    std::istringstream copy(chunk);
+                    chunkFcn(&chunkTag[0], static_cast<unsigned>(chunksize), copy);
+                }
+                continue;
             }
-            if (skip)
+            if (strncmp(&chunkTag[0], "data", chunkTag.size()) != 0)
             {
                 auto toSkip = inputFile.tellg();
-                toSkip += chunksize;
+                toSkip += static_cast<std::streamoff>(chunksize + padding(chunksize));
                 if (chunkFcn)
-                    chunkFcn(&chunkTag[0], chunksize, inputFile);
+                    chunkFcn(&chunkTag[0], static_cast<unsigned>(chunksize), inputFile);
                 inputFile.seekg(toSkip);
                 continue;
             }
+            if (container == RF64 && chunksize == 0xFFFFFFFFu)
+                chunksize = ds64DataSize;
+            if (!seekable)
+            {   // no end of file to go by
+                streamBytes = 0;
+                declaredDataSize = chunksize;
+                dataChunkSizeKnown = !streamingDataSize(chunksize);
+                dataChunkSize = dataChunkSizeKnown ? chunksize :
+                    std::numeric_limits<uint64_t>::max() / std::max<uint16_t>(blockAlign, 1) * blockAlign;
+                return true;
+            }
             auto here = inputFile.tellg();
             dataChunkBegin = here;
-            if (chunksize == 0) // reading an incompletely written file
+            inputFile.seekg(0, inputFile.end);
+            auto inFile = static_cast<uint64_t>(inputFile.tellg() - here);
+            inputFile.seekg(here);
+            declaredDataSize = chunksize;
+            dataChunkGrowing = chunksize == 0 || chunksize > inFile;
+            if (dataChunkGrowing) // reading an incompletely written file
+                chunksize = inFile; // read to end of file.
+            dataChunkSize = chunksize;
+            return true;
+        }
+        return false;
+    }
+
+    // For a 'data' chunk that was still being written when FindDataChunk found it (its size was zero, or
+    // past the end of the file): take in the frames written since. Returns true if there are more.
+    // Call it from the AtEndFcn_t of ProcessChunks, whose next pass goes on from where the last one stopped.
+    bool ExtendDataChunk()
+    {
+        if (!dataChunkGrowing || blockAlign == 0)
+            return false;
+        uint64_t inFile;
+        const uint64_t begin = static_cast<uint64_t>(static_cast<std::streamoff>(dataChunkBegin));
+        if (mappedFile)
+        {
+            mappedFile->Refresh();
+            inFile = mappedFile->get_fileSize() > begin ? mappedFile->get_fileSize() - begin : 0;
+        }
+        else
+        {   // (a read ahead that got to the end of 'data' is done with inputFile.)
+            inputFile.clear();
+            auto here = inputFile.tellg();
+            inputFile.seekg(0, inputFile.end);
+            inFile = static_cast<uint64_t>(inputFile.tellg() - dataChunkBegin);
+            // back to the first frame not yet handed out, if the last read ended part way into one
+            inputFile.seekg(dataChunkBegin + static_cast<std::streamoff>((here - dataChunkBegin) / blockAlign * blockAlign));
+        }
+        if (declaredDataSize != 0 && inFile >= declaredDataSize)
+        {
+            inFile = declaredDataSize;
+            dataChunkGrowing = false; // complete
+        }
+        inFile = inFile / blockAlign * blockAlign;
+        if (inFile <= dataChunkSize)
+            return false;
+        if (readAhead)
+            startReadAhead(readAheadFrame, inFile - readAheadFrame * blockAlign);
+        dataChunkSize = inFile;
+        return true;
+    }
+
+    void ProcessChunks(const DataChunkFcn_t& dataFcn, const RiffChunkFcn_t &chunkFcn = RiffChunkFcn_t(),
+            const AtEndFcn_t &atEnd = AtEndFcn_t())
+    {
+        if (!FindDataChunk(chunkFcn))
+            return;
+        if (mappedFile)
+        {
+            mappedFrame = 0;
+            for (;;)
             {
-                // read to end of file.
-                inputFile.seekg(0, inputFile.end);
-                chunksize = static_cast<uint32_t>(inputFile.tellg() - here);
-                inputFile.seekg(here);
+                processMapped(dataFcn, mappedEndFrame());
+                if (!atEnd || atEnd())
+                    break;
             }
-            dataChunkSize = chunksize;
-            std::vector<unsigned char> chunkBuffer(blockAlign * 100);
+            mappedFile->UnmapView();
+            return;
+        }
+        if (readAheadBuffers != 0 && seekable)
+        {
+            startReadAhead(0, dataChunkSize);
             for (;;)
             {
-                while (!inputFile.eof())
-                {
-                    inputFile.read(reinterpret_cast<char*>(&chunkBuffer[0]), chunkBuffer.size());
-                    auto chunkBufferSize = inputFile.gcount();
-                    if (chunkBufferSize == 0)
-                        break;
-                    unsigned char* p = &chunkBuffer[0];
-                    unsigned numFrames = static_cast<unsigned>( chunkBufferSize / blockAlign);
-                    if (dataFcn && !dataFcn(p, numFrames))
-                        break;
-                }
+                processReadAhead(dataFcn);
                 if (!atEnd || atEnd())
                     break;
             }
             return;
         }
+        std::vector<unsigned char> chunkBuffer(blockAlign * READ_FRAMES);
+        for (;;)
+        {
+            while (!inputFile.eof())
+            {
+                inputFile.read(reinterpret_cast<char*>(&chunkBuffer[0]), chunkBuffer.size());
+                auto chunkBufferSize = inputFile.gcount();
+                if (chunkBufferSize == 0)
+                    break;
+                streamBytes += static_cast<uint64_t>(chunkBufferSize);
+                unsigned char* p = &chunkBuffer[0];
+                unsigned numFrames = static_cast<unsigned>( chunkBufferSize / blockAlign);
+                if (dataFcn && !dataFcn(p, numFrames))
+                    break;
+            }
+            if (!atEnd || atEnd())
+                break;
+        }
+    }
+
+    // Read only frames firstFrame through firstFrame + numFrames - 1, or to the end of 'data'.
+    // Only valid after FindDataChunk, on an input that can seek. Any number of RiffReaders, each with its own
+    // ifstream, can do this on the same file at the same time.
+    void ProcessFrames(uint64_t firstFrame, uint64_t numFrames, const DataChunkFcn_t& dataFcn)
+    {
+        if (blockAlign == 0)
+            return;
+        uint64_t totalFrames = dataChunkSize / blockAlign;
+        if (firstFrame >= totalFrames)
+            return;
+        numFrames = std::min(numFrames, totalFrames - firstFrame);
+        if (mappedFile)
+        {
+            mappedFrame = firstFrame;
+            processMapped(dataFcn, std::min(firstFrame + numFrames, mappedEndFrame()));
+            mappedFile->UnmapView();
+            return;
+        }
+        if (readAheadBuffers != 0)
+        {
+            startReadAhead(firstFrame, numFrames * blockAlign);
+            processReadAhead(dataFcn);
+            return;
+        }
+        auto pos = dataChunkBegin;
+        pos += static_cast<std::streamoff>(firstFrame) * blockAlign;
+        inputFile.clear();
+        inputFile.seekg(pos);
+        std::vector<unsigned char> chunkBuffer(blockAlign * READ_FRAMES);
+        while (numFrames > 0 && !inputFile.eof())
+        {
+            unsigned toRead = static_cast<unsigned>(std::min<uint64_t>(numFrames, READ_FRAMES));
+            inputFile.read(reinterpret_cast<char*>(&chunkBuffer[0]), static_cast<std::streamsize>(toRead) * blockAlign);
+            unsigned framesRead = static_cast<unsigned>(inputFile.gcount() / blockAlign);
+            if (framesRead == 0)
+                break;
+            numFrames -= framesRead;
+            if (dataFcn && !dataFcn(&chunkBuffer[0], framesRead))
+                break;
+        }
     }
  
-    unsigned CurrentFrameNumber() const 
+    uint64_t CurrentFrameNumber() const 
     {   // only valid after reading 'data'
         if (dataChunkSize == 0 || blockAlign == 0)
             return 0;
+        if (mappedFile)
+            return mappedFrame;
+        if (readAhead)
+            return readAheadFrame;
+        if (!seekable)
+            return streamBytes / blockAlign;
         if (!inputFile.eof())
-            return static_cast<unsigned>(inputFile.tellg() - dataChunkBegin) / blockAlign;
+            return static_cast<uint64_t>(inputFile.tellg() - dataChunkBegin) / blockAlign;
         return dataChunkSize / blockAlign;
     }
 
-    void SeekToFrameNumber(unsigned frame)
+    void SeekToFrameNumber(uint64_t frame)
     {
         if (dataChunkSize != 0)
         {   // can only seek if we have made it to the beginning of 'data'
+            if (mappedFile)
+            {   // takes effect at the next span
+                if (frame * blockAlign <= dataChunkSize)
+                    mappedFrame = frame;
+                return;
+            }
+            if (readAhead)
+            {   // the reader thread owns inputFile. it starts over at frame.
+                if (frame * blockAlign <= dataChunkSize)
+                    startReadAhead(frame, dataChunkSize - frame * blockAlign);
+                return;
+            }
+            if (!seekable)
+            {   // read up to it. there is no going back.
+                if (frame * blockAlign > streamBytes && frame * blockAlign <= dataChunkSize)
+                {
+                    inputFile.ignore(static_cast<std::streamsize>(frame * blockAlign - streamBytes));
+                    streamBytes += static_cast<uint64_t>(inputFile.gcount());
+                }
+                return;
+            }
             auto pos = dataChunkBegin;
-            pos += frame * blockAlign;
+            pos += static_cast<std::streamoff>(frame * blockAlign);
             auto end = dataChunkBegin;
-            end += dataChunkSize;
+            end += static_cast<std::streamoff>(dataChunkSize);
             if (pos > 0 && pos <= end)
             {
                 if (inputFile.eof())
@@ -171,16 +379,157 @@ public:
     uint32_t get_byteRate() const { return byteRate;}
     uint16_t get_blockAlign() const { return blockAlign;}
     uint16_t get_bitsPerSample() const { return bitsPerSample;}
-    uint32_t get_dataChunkSize() const { return dataChunkSize;}
+    uint64_t get_dataChunkSize() const { return dataChunkSize;}
+    bool get_dataChunkGrowing() const { return dataChunkGrowing; } // ExtendDataChunk might find more
+    // false for a stream whose 'data' goes on to its end, like a pipe from a recorder. 
+    // get_dataChunkSize is then as big as can be.
+    bool get_dataChunkSizeKnown() const { return dataChunkSizeKnown; }
+    bool get_seekable() const { return seekable; } // valid after ParseHeader
+    Container get_container() const { return container; }
 
 protected:
-    std::ifstream &inputFile;
+    enum {READ_FRAMES = 100, MAPPED_SPAN_BYTES = 1 << 23, WAVE64_CHUNK_HEADER_BYTES = 24};
+
+    uint64_t readLittleEndian(unsigned bytes)
+    {
+        unsigned char buf[8] = {};
+        inputFile.read(reinterpret_cast<char*>(buf), bytes);
+        uint64_t v = 0;
+        for (int i = static_cast<int>(bytes) - 1; i >= 0; i -= 1)
+        {
+            v <<= 8;
+            v |= buf[i];
+        }
+        return v;
+    }
+
+    // having read the first four bytes of a Wave64 GUID to buf, reads the rest and checks them.
+    bool readWave64Guid(const char* fourcc, std::vector<char>& buf)
+    {
+        unsigned char guid[16];
+        Wave64Guid(fourcc, guid);
+        inputFile.read(&buf[4], 12);
+        return memcmp(&buf[0], guid, 16) == 0;
+    }
+
+    // The four character code of the next chunk to tag, and the size of what follows its header.
+    // Returns false at the end of the file.
+    bool readChunkHeader(char* tag, uint64_t& chunksize)
+    {
+        if (container == WAVE64)
+        {   // the GUID starts with the four character code, and the size counts the header
+            char guid[16];
+            inputFile.read(guid, sizeof(guid));
+            memcpy(tag, guid, 4);
+            chunksize = readLittleEndian(8);
+            chunksize = chunksize > WAVE64_CHUNK_HEADER_BYTES ? chunksize - WAVE64_CHUNK_HEADER_BYTES : 0;
+        }
+        else
+        {
+            inputFile.read(tag, 4);
+            chunksize = readLittleEndian(4);
+        }
+        return !inputFile.eof();
+    }
+
+    // Wave64 chunks start on 8 byte boundaries. (RIFF ones are supposed to start on even ones,
+    // but the RIFF files this reads don't all bother.)
+    uint64_t padding(uint64_t chunksize) const
+    {   return container == WAVE64 ? (8 - chunksize % 8) % 8 : 0;  }
+
+    void skip(uint64_t bytes)
+    {
+        if (seekable)
+            inputFile.seekg(static_cast<std::streamoff>(bytes + padding(bytes)), inputFile.cur);
+        else
+            inputFile.ignore(static_cast<std::streamsize>(bytes + padding(bytes)));
+    }
+
+    // The sizes a writer that can't seek back puts in its header: zero, or all ones.
+    bool streamingDataSize(uint64_t chunksize) const
+    {
+        return chunksize == 0 || (container == RIFF && chunksize == 0xFFFFFFFFu) ||
+            chunksize >= std::numeric_limits<uint64_t>::max() - WAVE64_CHUNK_HEADER_BYTES;
+    }
+
+    // the end of 'data', or of the file if it was cut short.
+    uint64_t mappedEndFrame() const
+    {
+        uint64_t begin = static_cast<uint64_t>(static_cast<std::streamoff>(dataChunkBegin));
+        uint64_t inFile = mappedFile->get_fileSize() > begin ? (mappedFile->get_fileSize() - begin) / blockAlign : 0;
+        return std::min<uint64_t>(dataChunkSize / blockAlign, inFile);
+    }
+
+    // Hand out the frames from mappedFrame up to endFrame a span at a time.
+    // A SeekToFrameNumber from inside dataFcn changes where the next span starts.
+    bool processMapped(const DataChunkFcn_t& dataFcn, uint64_t endFrame)
+    {
+        const unsigned spanFrames = std::max(1u, static_cast<unsigned>(MAPPED_SPAN_BYTES / blockAlign));
+        const uint64_t begin = static_cast<uint64_t>(static_cast<std::streamoff>(dataChunkBegin));
+        while (mappedFrame < endFrame)
+        {
+            unsigned numFrames = static_cast<unsigned>(std::min<uint64_t>(spanFrames, endFrame - mappedFrame));
+            unsigned char* p = mappedFile->MapView(begin + mappedFrame * blockAlign,
+                static_cast<size_t>(numFrames) * blockAlign);
+            if (p == nullptr)
+                return false;
+            mappedFrame += numFrames;
+            if (mappedFrame < endFrame) // get the OS reading the next one while this one is processed
+                mappedFile->Prefetch(begin + mappedFrame * blockAlign,
+                    static_cast<size_t>(std::min<uint64_t>(spanFrames, endFrame - mappedFrame)) * blockAlign);
+            if (dataFcn && !dataFcn(p, numFrames))
+                return false;
+        }
+        return true;
+    }
+
+    void startReadAhead(uint64_t frame, uint64_t byteCount)
+    {
+        if (!readAhead)
+        {
+            size_t frames = std::max(1u, readAheadBytes / blockAlign);
+            readAhead.reset(new CReadAhead(inputFile, readAheadBuffers, frames * blockAlign));
+        }
+        readAheadFrame = frame;
+        auto pos = dataChunkBegin;
+        pos += static_cast<std::streamoff>(frame * blockAlign);
+        readAhead->Start(pos, byteCount);
+    }
+
+    bool processReadAhead(const DataChunkFcn_t& dataFcn)
+    {
+        unsigned char* p = nullptr;
+        size_t bytes;
+        while ((bytes = readAhead->Next(p)) != 0)
+        {
+            unsigned numFrames = static_cast<unsigned>(bytes / blockAlign);
+            readAheadFrame += numFrames;
+            if (dataFcn && !dataFcn(p, numFrames))
+                return false;
+        }
+        return true;
+    }
+
+    std::istream &inputFile;
+    bool seekable;
+    uint64_t streamBytes; // of 'data' read so far, if not seekable
+    std::unique_ptr<CMappedFile> mappedFile;
+    uint64_t mappedFrame; // the next one to hand out
+    std::unique_ptr<CReadAhead> readAhead;
+    unsigned readAheadBuffers;
+    unsigned readAheadBytes;
+    uint64_t readAheadFrame; // the one after those handed out
     std::streampos dataChunkBegin;
+    Container container;
+    uint64_t ds64DataSize; // RF64's
+    uint64_t declaredDataSize; // what the 'data' header says. zero for unknown
+    bool dataChunkGrowing; // the recorder was still writing it
+    bool dataChunkSizeKnown;
     uint16_t format;
     uint16_t numChannels;
     uint32_t sampleRate;
     uint32_t byteRate;
     uint16_t blockAlign;
     uint16_t bitsPerSample;
-    uint32_t dataChunkSize;
+    uint64_t dataChunkSize;
 };
@@ -0,0 +1,329 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#pragma once
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <ctime>
+#include <functional>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "RiffReader.h"
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+// A recording that the recorder split into several WAVE files, read as one. The files are put in
+// order of their start times, and their 'data' frames are numbered as if they were all one 'data'
+// chunk. Each file is read by its own RiffReader, whose spans go straight to the DataChunkFcn_t,
+// which sees one continuous stream across the file boundaries. The files must all be in the same
+// format, and each must begin where the one before it ended.
+// A RiffSequence of one file reads it exactly as a RiffReader does.
+// The file name "-" is standard input, which can only be the one file.
+class RiffSequence {
+public:
+    RiffSequence(const std::vector<std::string>& fileNames)
+        : current(0)
+        , nextFrame(0)
+        , seekPending(false)
+        , dataChunkSize(0)
+    {
+        if (fileNames.empty())
+            throw std::runtime_error("No input file specified");
+        if (fileNames.size() > 1 && std::find_if(fileNames.begin(), fileNames.end(), IsStandardInput) != fileNames.end())
+            throw std::runtime_error("Standard input cannot be one of several input files");
+        for (auto& fileName : fileNames)
+        {
+            std::unique_ptr<Part> part(new Part(fileName));
+            if (!IsStandardInput(fileName) && !part->inputFile.is_open())
+                throw std::runtime_error("Failed to open input \"" + fileName + "\"");
+            parts.push_back(std::move(part));
+        }
+    }
+
+    // RiffReader::MapFile for each file. Returns false if any can't be mapped (and is read through its ifstream.)
+    bool MapFiles()
+    {
+        bool mapped = true;
+        for (auto& p : parts)
+            mapped = p->rr.MapFile(p->fileName) && mapped;
+        return mapped;
+    }
+
+    void ReadAhead(unsigned numBuffers, unsigned bufferBytes)
+    {
+        for (auto& p : parts)
+            p->rr.ReadAhead(numBuffers, bufferBytes);
+    }
+
+    CReadAhead::Stats get_readAheadStats() const
+    {
+        CReadAhead::Stats total;
+        for (auto& p : parts)
+        {
+            CReadAhead::Stats s = p->rr.get_readAheadStats();
+            total.buffersRead += s.buffersRead;
+            total.consumerStalls += s.consumerStalls;
+            total.readerStalls += s.readerStalls;
+            total.maxQueueDepth = std::max(total.maxQueueDepth, s.maxQueueDepth);
+        }
+        return total;
+    }
+
+    // Parse each file's header. With more than one file, also find their start times in the chunks
+    // ahead of 'data', put the files in that order (if every one has a start time, else leave them
+    // in the order given) and check that they are all in the same format.
+    void ParseHeader()
+    {
+        for (auto& p : parts)
+            p->rr.ParseHeader();
+        if (parts.size() == 1)
+            return;
+        for (auto& p : parts)
+        {
+            Part& part = *p;
+            if (!part.rr.FindDataChunk([&part](const char* tag, unsigned chunkSize, std::istream& infile)
+                {
+                    if (part.startTime == 0)
+                        part.startTime = readStartTime(tag, chunkSize, infile);
+                }))
+                throw std::runtime_error("Input \"" + part.fileName + "\" has no data");
+        }
+        if (std::all_of(parts.begin(), parts.end(), [](const std::unique_ptr<Part>& p) { return p->startTime != 0; }))
+            std::stable_sort(parts.begin(), parts.end(), [](const std::unique_ptr<Part>& a, const std::unique_ptr<Part>& b)
+                { return a->startTime < b->startTime; });
+        const RiffReader& first = parts.front()->rr;
+        for (auto& p : parts)
+        {
+            const RiffReader& rr = p->rr;
+            if (rr.get_format() != first.get_format() || rr.get_numChannels() != first.get_numChannels() ||
+                rr.get_sampleRate() != first.get_sampleRate() || rr.get_blockAlign() != first.get_blockAlign() ||
+                rr.get_bitsPerSample() != first.get_bitsPerSample())
+                throw std::runtime_error("Input \"" + p->fileName + "\" is not in the same format as \"" +
+                    parts.front()->fileName + "\"");
+            // back to the end of the header, for FindDataChunk to hand the chunks to its caller
+            p->inputFile.clear();
+            p->inputFile.seekg(0);
+            p->rr.ParseHeader();
+        }
+        numberFrames(); // so get_dataChunkSize is known already
+    }
+
+    // Find each file's 'data'. Only the first file's chunks go to chunkFcn. Returns false if any has no 'data'.
+    bool FindDataChunk(const RiffReader::RiffChunkFcn_t& chunkFcn = RiffReader::RiffChunkFcn_t())
+    {
+        for (auto& p : parts)
+            if (!p->rr.FindDataChunk(p == parts.front() ? chunkFcn : RiffReader::RiffChunkFcn_t()))
+                return false;
+        numberFrames();
+        current = 0;
+        nextFrame = 0;
+        return true;
+    }
+
+    // As RiffReader::ProcessChunks, where a SeekToFrameNumber from dataFcn or atEnd can be into any of the files.
+    void ProcessChunks(const RiffReader::DataChunkFcn_t& dataFcn, const RiffReader::RiffChunkFcn_t& chunkFcn = RiffReader::RiffChunkFcn_t(),
+        const RiffReader::AtEndFcn_t& atEnd = RiffReader::AtEndFcn_t())
+    {
+        if (parts.size() == 1)
+        {
+            parts.front()->rr.ProcessChunks(dataFcn, chunkFcn, atEnd);
+            return;
+        }
+        if (!FindDataChunk(chunkFcn))
+            return;
+        for (;;)
+        {
+            while (current < parts.size())
+            {
+                Part& p = *parts[current];
+                bool stopped = false;
+                seekPending = false;
+                p.rr.ProcessFrames(nextFrame - p.firstFrame, p.numFrames, [&](unsigned char* data, unsigned numFrames)
+                    {
+                        nextFrame += numFrames;
+                        if (dataFcn && !dataFcn(data, numFrames))
+                        {
+                            stopped = true;
+                            return false;
+                        }
+                        return !seekPending; // else start over wherever it is
+                    });
+                if (stopped)
+                    break;
+                if (seekPending)
+                    continue;
+                if (++current < parts.size()) // even if this file came up short
+                    nextFrame = parts[current]->firstFrame;
+            }
+            if (!atEnd || atEnd())
+                break;
+        }
+    }
+
+    // As RiffReader::ProcessFrames, across as many of the files as it takes.
+    void ProcessFrames(uint64_t firstFrame, uint64_t numFrames, const RiffReader::DataChunkFcn_t& dataFcn)
+    {
+        for (auto& p : parts)
+        {
+            if (numFrames == 0)
+                break;
+            if (firstFrame >= p->firstFrame + p->numFrames)
+                continue;
+            const uint64_t frame = firstFrame - p->firstFrame;
+            const uint64_t n = std::min(numFrames, p->numFrames - frame);
+            bool stopped = false;
+            p->rr.ProcessFrames(frame, n, [&](unsigned char* data, unsigned count)
+                {
+                    stopped = dataFcn && !dataFcn(data, count);
+                    return !stopped;
+                });
+            if (stopped)
+                break;
+            firstFrame += n;
+            numFrames -= n;
+        }
+    }
+
+    // As RiffReader::ExtendDataChunk. Only the last file can still be growing.
+    bool ExtendDataChunk()
+    {
+        if (parts.size() == 1)
+            return parts.front()->rr.ExtendDataChunk();
+        if (!parts.back()->rr.ExtendDataChunk())
+            return false;
+        numberFrames();
+        if (current == parts.size())
+            current = parts.size() - 1; // ProcessChunks picks up where the last file ended
+        return true;
+    }
+
+    uint64_t CurrentFrameNumber() const
+    {
+        if (parts.size() == 1)
+            return parts.front()->rr.CurrentFrameNumber();
+        return nextFrame;
+    }
+
+    // Only valid after FindDataChunk. Takes effect when dataFcn or atEnd returns.
+    void SeekToFrameNumber(uint64_t frame)
+    {
+        if (parts.size() == 1)
+        {
+            parts.front()->rr.SeekToFrameNumber(frame);
+            return;
+        }
+        if (dataChunkSize == 0 || frame * get_blockAlign() > dataChunkSize)
+            return;
+        for (current = 0; current < parts.size(); current++)
+            if (frame < parts[current]->firstFrame + parts[current]->numFrames)
+                break;
+        nextFrame = frame;
+        seekPending = true;
+    }
+
+    uint16_t get_format() const { return parts.front()->rr.get_format(); }
+    uint16_t get_numChannels() const { return parts.front()->rr.get_numChannels(); }
+    uint32_t get_sampleRate() const { return parts.front()->rr.get_sampleRate(); }
+    uint32_t get_byteRate() const { return parts.front()->rr.get_byteRate(); }
+    uint16_t get_blockAlign() const { return parts.front()->rr.get_blockAlign(); }
+    uint16_t get_bitsPerSample() const { return parts.front()->rr.get_bitsPerSample(); }
+    uint64_t get_dataChunkSize() const // of all the files' 'data'
+    {   return parts.size() == 1 ? parts.front()->rr.get_dataChunkSize() : dataChunkSize;  }
+    bool get_dataChunkGrowing() const { return parts.back()->rr.get_dataChunkGrowing(); }
+    size_t get_fileCount() const { return parts.size(); }
+    const std::string& get_lastFileName() const { return parts.back()->fileName; }
+    bool get_dataChunkSizeKnown() const { return parts.size() > 1 || parts.front()->rr.get_dataChunkSizeKnown(); }
+
+    static bool IsStandardInput(const std::string& fileName) { return fileName == "-"; }
+
+protected:
+    struct Part {
+        Part(const std::string& fileName)
+            : fileName(fileName)
+            , inputFile()
+            , rr(IsStandardInput(fileName) ? std::cin : inputFile)
+            , startTime(0)
+            , firstFrame(0)
+            , numFrames(0)
+        {
+            if (!IsStandardInput(fileName))
+                inputFile.open(fileName.c_str(), std::ifstream::binary);
+#if defined(_WIN32)
+            else
+                _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        }
+        std::string fileName;
+        std::ifstream inputFile; // not opened for standard input
+        RiffReader rr;
+        uint64_t startTime; // zero if the file doesn't say
+        uint64_t firstFrame; // of the sequence
+        uint64_t numFrames;
+    };
+
+    // Each file's frames follow those of the file before it.
+    void numberFrames()
+    {
+        uint64_t frames = 0;
+        for (auto& p : parts)
+        {
+            p->firstFrame = frames;
+            p->numFrames = get_blockAlign() == 0 ? 0 : p->rr.get_dataChunkSize() / get_blockAlign();
+            frames += p->numFrames;
+        }
+        dataChunkSize = frames * get_blockAlign();
+    }
+
+    // HDSDR and SpectraVue record a SYSTEMTIME in their 'auxi' chunk, and SliceIQ its --outputStartTime
+    // in '0SDR'. Either becomes a number that sorts in time order, or zero if this chunk has neither.
+    static uint64_t readStartTime(const char* tag, unsigned chunkSize, std::istream& infile)
+    {
+        unsigned t[7] = {}; // year, month, day, hour, minute, second, millisecond
+        if (strncmp(tag, "auxi", 4) == 0 && chunkSize >= 16)
+        {   // wYear, wMonth, wDayOfWeek, wDay, wHour, wMinute, wSecond, wMilliseconds
+            unsigned char st[16];
+            infile.read(reinterpret_cast<char*>(st), sizeof(st));
+            static const unsigned fields[7] = { 0, 1, 3, 4, 5, 6, 7 };
+            for (unsigned i = 0; i < 7; i++)
+                t[i] = st[2 * fields[i]] | (st[2 * fields[i] + 1] << 8);
+        }
+        else if (strncmp(tag, "0SDR", 4) == 0)
+        {
+            std::string s(chunkSize, ' ');
+            infile.read(&s[0], chunkSize);
+            static const char StartTimeArg[] = "--outputStartTime=";
+            auto pos = s.find(StartTimeArg);
+            if (pos == s.npos)
+                return 0;
+            std::tm tm = {};
+            std::istringstream iss(s.substr(pos + sizeof(StartTimeArg) - 1));
+            iss >> std::get_time(&tm, "%Y/%m/%d-%H:%M:%S");
+            if (iss.fail())
+                return 0;
+            t[0] = tm.tm_year + 1900; t[1] = tm.tm_mon + 1; t[2] = tm.tm_mday;
+            t[3] = tm.tm_hour; t[4] = tm.tm_min; t[5] = tm.tm_sec;
+        }
+        else
+            return 0;
+        uint64_t v = t[0];
+        v = v * 13 + t[1];
+        v = v * 32 + t[2];
+        v = v * 24 + t[3];
+        v = v * 60 + t[4];
+        v = v * 60 + t[5];
+        return v * 1000 + t[6];
+    }
+
+    std::vector<std::unique_ptr<Part>> parts;
+    size_t current; // the part nextFrame is in
+    uint64_t nextFrame; // the one after those handed out
+    bool seekPending;
+    uint64_t dataChunkSize;
+};
@@ -0,0 +1,66 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#pragma once
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+// Fixed size queue between exactly one producer thread and one consumer thread.
+// Neither side ever locks or waits: TryPush fails when the ring is full, and TryPop when it is empty.
+// The items are copied in and out, so T should be small and fixed size.
+template <class T>
+class CSpscRing
+{
+public:
+    // capacity is rounded up to a power of two
+    explicit CSpscRing(size_t capacity)
+        : m_head(0)
+        , m_tail(0)
+    {
+        size_t sze = 1;
+        while (sze < capacity)
+            sze <<= 1;
+        m_items.resize(sze);
+        m_mask = sze - 1;
+    }
+
+    // producer only
+    bool TryPush(const T& item)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) > m_mask)
+            return false; // full
+        m_items[tail & m_mask] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only
+    bool TryPop(T& item)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false; // empty
+        item = m_items[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Either thread. Only a snapshot, as the other side may be moving.
+    bool empty() const { return get_size() == 0; }
+    size_t get_size() const
+    {   // head first: the tail read after it can't be behind it
+        const size_t head = m_head.load(std::memory_order_acquire);
+        return m_tail.load(std::memory_order_acquire) - head;
+    }
+    size_t get_capacity() const { return m_items.size(); }
+
+private:
+    CSpscRing(const CSpscRing&) = delete;
+    CSpscRing& operator = (const CSpscRing&) = delete;
+    std::vector<T> m_items;
+    size_t m_mask;
+    // padded onto separate cache lines so the producer and consumer don't fight over one
+    std::atomic<size_t> m_head; // next to pop. written only by the consumer
+    char m_padding[64];
+    std::atomic<size_t> m_tail; // next to push. written only by the producer
+};
@@ -0,0 +1,468 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+
+/* HeadlessSDR
+** Command line program that plays an I/Q file through SimpleSdrImpl, as ReviewRecordedIQ does, but into the
+** sinks in LinuxAudio's HeadlessAudioSinks.h instead of a sound card. It plays the file once through each
+** sink, and prints how fast the audio came (its real time factor), how long after Play the first of it
+** came, and, for the paced sink, how long the audio waited in its jitter buffer.
+**
+** HeadlessSDR <InputFile.wav>
+**
+** --sink=null|wav|fifo|all
+**      null counts the audio and discards it, so its real time factor is how fast SimpleSdrImpl can go.
+**      wav writes the audio to --wavFile as fast as it comes. fifo writes it to --fifo at the pace of a
+**      sound card. The default is all three, one after the other.
+** --wavFile=<path>
+**      Default HeadlessSDR.wav
+** --fifo=<path>
+**      The named pipe, created if it doesn't exist. Default HeadlessSDR.fifo. HeadlessSDR reads it itself,
+**      unless --externalFifoReader, for example to hear it with: aplay -f S16_LE -r 12000 HeadlessSDR.fifo
+** --jitterBufferMsec=nnnn
+**      Default 100
+** --seconds=nnnn
+**      Stop once at least that much of the input has played through each sink. The default is all of it.
+** --centerHz=nnnn
+** --weaverHz=nnnn
+**      Tune the receiver, as DemodIQ does. Default 0 and 1100.
+**
+** HeadlessSDR --test [<scratch directory>]
+**      Writes a made up four second 12KHz input with a tone, plays it through each sink, and checks that
+**      each got all the audio, that the null sink ran faster than real time, that the WAV file has the
+**      tone in it, and that the paced sink ran at real time and its reader got the audio. The files are
+**      removed if all the checks pass. Exits with 1 if any failed.
+**
+** The sinks are POSIX, so HeadlessSDR builds only on Linux, with the Makefile here.
+*/
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <SimpleSdrImpl.h>
+#include <HeadlessAudioSinks.h>
+
+namespace {
+    const char SinkArg[] = "--sink=";
+    const char WavFileArg[] = "--wavFile=";
+    const char FifoArg[] = "--fifo=";
+    const char ExternalFifoReaderArg[] = "--externalFifoReader";
+    const char JitterBufferArg[] = "--jitterBufferMsec=";
+    const char SecondsArg[] = "--seconds=";
+    const char CenterHzArg[] = "--centerHz=";
+    const char WeaverHzArg[] = "--weaverHz=";
+    const char TestArg[] = "--test";
+
+    typedef XDSdr::impl::SimpleSDR SimpleSDR;
+    typedef XDSdr::impl::SimpleSdrDemodulator SimpleSdrDemodulator;
+    typedef std::chrono::steady_clock steady_clock_t;
+
+    // A play is given up on when the audio stops for this long before the end
+    const std::chrono::milliseconds IDLE_AT_END(1000);
+    // or none has come after this long
+    const std::chrono::seconds NEVER_STARTED(10);
+
+    const unsigned TEST_SECONDS = 4;
+    const double TEST_TONE_HZ = 1000; // relative to the input's center
+    const double TEST_TONE_AMPLITUDE = 0.1;
+
+    int usage()
+    {
+        std::cerr << "Usage: HeadlessSDR [inputFile.wav] [" << SinkArg << "null|wav|fifo|all] [" << WavFileArg << "path] ["
+            << FifoArg << "path]" << std::endl
+            << " [" << ExternalFifoReaderArg << "] [" << JitterBufferArg << "n] [" << SecondsArg << "s] ["
+            << CenterHzArg << "f] [" << WeaverHzArg << "f]" << std::endl
+            << "   or: HeadlessSDR " << TestArg << " [scratch directory]" << std::endl;
+        return 1;
+    }
+
+    struct Settings {
+        Settings()
+            : sinks("all")
+            , wavFile("HeadlessSDR.wav")
+            , fifo("HeadlessSDR.fifo")
+            , externalFifoReader(false)
+            , jitterBufferMsec(100)
+            , seconds(-1)
+            , centerHz(0)
+            , weaverHz(1100)
+        {}
+        std::string sinks;
+        std::string wavFile;
+        std::string fifo;
+        bool externalFifoReader;
+        unsigned jitterBufferMsec;
+        double seconds;
+        float centerHz;
+        float weaverHz;
+    };
+
+    // What one play through one sink measured
+    struct Played {
+        Played() : frames(0), realTimeFactor(0), firstAudioSeconds(0), maxCallGapSeconds(0) {}
+        uint64_t frames;
+        double realTimeFactor;
+        double firstAudioSeconds;
+        double maxCallGapSeconds;
+    };
+
+    // Play the input from the start through sink, until maxFrames, or all of it, have come.
+    bool play(const std::string& inputFileName, const Settings& settings, XD::NullSink& sink, uint64_t maxFrames,
+        Played& played)
+    {
+        std::string statistics;
+        {
+            SimpleSDR sdr(inputFileName, &sink);
+            sdr.SetRxFrequencyCenterHz(settings.centerHz);
+            sdr.SetRxFrequencyBfoOffsetHz(settings.weaverHz);
+            sdr.SetBandwidth(SimpleSDR::WIDE_SSB);
+            const auto started = steady_clock_t::now();
+            sdr.Play();
+            uint64_t frames = 0;
+            auto lastChange = started;
+            for (;;)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                const auto now = steady_clock_t::now();
+                const uint64_t f = sink.get_frames();
+                if (f != frames)
+                {
+                    frames = f;
+                    lastChange = now;
+                }
+                // AudioComplete isn't called, so the end is when all the input's frames have come. The
+                // length is known once the reader thread has found the 'data'.
+                const uint64_t length = std::llround(sdr.GetPlayLengthSeconds() * SimpleSdrDemodulator::get_framesPerSecond());
+                if (frames >= maxFrames || (length > 0 && frames >= length))
+                    break;
+                if (frames == 0 ? now - started > NEVER_STARTED : now - lastChange > IDLE_AT_END)
+                    break;
+            }
+            statistics = sdr.GetPipelineStatistics();
+            played.firstAudioSeconds = sink.get_firstCallSeconds(started);
+            sdr.Close(); // which releases the sink
+        }
+        played.frames = sink.get_frames();
+        played.realTimeFactor = sink.RealTimeFactor();
+        played.maxCallGapSeconds = sink.get_maxCallGapSeconds();
+        std::cout << "    " << played.frames << " frames (" << static_cast<double>(played.frames) / SimpleSdrDemodulator::get_framesPerSecond()
+            << " seconds) at " << played.realTimeFactor << " times real time" << std::endl
+            << "    first audio " << 1000 * played.firstAudioSeconds << " msec after Play, longest wait between calls "
+            << 1000 * played.maxCallGapSeconds << " msec" << std::endl
+            << "    " << statistics << std::endl;
+        return played.frames > 0;
+    }
+
+    // Stands in for aplay on the far end of the FIFO, and counts what comes through
+    class FifoReader {
+    public:
+        explicit FifoReader(const std::string& fifoName)
+            : m_fifoName(fifoName)
+            , m_stop(false)
+            , m_bytes(0)
+        {
+            m_thread = std::thread(&FifoReader::thread, this);
+        }
+        ~FifoReader() { Stop(); }
+
+        // Returns once the writer has closed its end, or the reader never got one
+        void Stop()
+        {
+            m_stop = true;
+            if (m_thread.joinable())
+                m_thread.join();
+        }
+        uint64_t get_bytes() const { return m_bytes; }
+
+    private:
+        void thread()
+        {
+            // Opened nonblocking, so the thread can quit if no writer ever comes
+            int fd = -1;
+            while (fd < 0 && !m_stop)
+            {
+                fd = open(m_fifoName.c_str(), O_RDONLY | O_NONBLOCK);
+                if (fd < 0)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            if (fd < 0)
+                return;
+            char buf[4096];
+            bool writerSeen = false;
+            for (;;)
+            {
+                ssize_t r = read(fd, buf, sizeof(buf));
+                if (r > 0)
+                {
+                    writerSeen = true;
+                    m_bytes += static_cast<uint64_t>(r);
+                    continue;
+                }
+                if (r == 0 && writerSeen)
+                    break; // the writer closed its end
+                if (r == 0 && m_stop)
+                    break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            close(fd);
+        }
+        const std::string m_fifoName;
+        std::atomic<bool> m_stop;
+        std::atomic<uint64_t> m_bytes;
+        std::thread m_thread;
+    };
+
+    struct Results {
+        Played null;
+        Played wav;
+        Played fifo;
+        double fifoAverageLatencySeconds = 0;
+        double fifoMaxLatencySeconds = 0;
+        unsigned fifoUnderruns = 0;
+        bool fifoFailed = false;
+        uint64_t fifoBytesRead = 0;
+    };
+
+    bool run(const std::string& inputFileName, const Settings& settings, Results& results)
+    {
+        const uint64_t maxFrames = settings.seconds < 0 ? UINT64_MAX :
+            static_cast<uint64_t>(settings.seconds * SimpleSdrDemodulator::get_framesPerSecond());
+        const bool all = settings.sinks == "all";
+        bool ok = true;
+        if (all || settings.sinks == "null")
+        {
+            std::cout << "null:" << std::endl;
+            XD::NullSink sink;
+            if (!play(inputFileName, settings, sink, maxFrames, results.null))
+                ok = false;
+        }
+        if (all || settings.sinks == "wav")
+        {
+            std::cout << "wav " << settings.wavFile << ":" << std::endl;
+            XD::WavFileSink sink(settings.wavFile);
+            if (!play(inputFileName, settings, sink, maxFrames, results.wav))
+                ok = false;
+            if (sink.get_failed())
+            {
+                std::cout << "    failed writing " << settings.wavFile << std::endl;
+                ok = false;
+            }
+        }
+        if (all || settings.sinks == "fifo")
+        {
+            std::cout << "fifo " << settings.fifo << ":" << std::endl;
+            XD::PacedFifoSink sink(settings.fifo, SimpleSdrDemodulator::get_framesPerSecond(), settings.jitterBufferMsec);
+            std::unique_ptr<FifoReader> reader;
+            if (!settings.externalFifoReader)
+                reader.reset(new FifoReader(settings.fifo));
+            if (!play(inputFileName, settings, sink, maxFrames, results.fifo))
+                ok = false;
+            if (reader)
+            {
+                reader->Stop();
+                results.fifoBytesRead = reader->get_bytes();
+            }
+            results.fifoAverageLatencySeconds = sink.get_averageLatencySeconds();
+            results.fifoMaxLatencySeconds = sink.get_maxLatencySeconds();
+            results.fifoUnderruns = sink.get_underruns();
+            results.fifoFailed = sink.get_failed();
+            std::cout << "    jitter buffer latency average " << 1000 * results.fifoAverageLatencySeconds << " msec, max "
+                << 1000 * results.fifoMaxLatencySeconds << " msec, " << results.fifoUnderruns << " underruns";
+            if (reader)
+                std::cout << ", " << results.fifoBytesRead << " bytes read";
+            if (results.fifoFailed)
+                std::cout << ", the reader went away";
+            std::cout << std::endl;
+        }
+        return ok;
+    }
+
+    template <class T>
+    void put(std::ofstream& f, T v)
+    {   // little endian, as RIFF is, on the machines this runs on
+        f.write(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    // 12KHz float I/Q, as SliceIQ writes, with a tone
+    bool writeTestInput(const std::string& fileName)
+    {
+        std::ofstream f(fileName, std::ios::binary);
+        if (!f)
+            return false;
+        const uint32_t rate = SimpleSdrDemodulator::get_framesPerSecond();
+        const uint32_t numFrames = rate * TEST_SECONDS;
+        const uint32_t dataBytes = numFrames * 2 * sizeof(float);
+        f.write("RIFF", 4);
+        put<uint32_t>(f, 4 + 8 + 16 + 8 + dataBytes);
+        f.write("WAVEfmt ", 8);
+        put<uint32_t>(f, 16);
+        put<uint16_t>(f, 3); // WAVE_FORMAT_IEEE_FLOAT
+        put<uint16_t>(f, 2);
+        put<uint32_t>(f, rate);
+        put<uint32_t>(f, rate * 2 * sizeof(float));
+        put<uint16_t>(f, 2 * sizeof(float));
+        put<uint16_t>(f, 32);
+        f.write("data", 4);
+        put<uint32_t>(f, dataBytes);
+        static const double TwoPi = 2. * 3.14159265358979323846264338;
+        for (uint32_t i = 0; i < numFrames; i++)
+        {
+            double w = TwoPi * TEST_TONE_HZ * i / rate;
+            put<float>(f, static_cast<float>(TEST_TONE_AMPLITUDE * cos(w)));
+            put<float>(f, static_cast<float>(TEST_TONE_AMPLITUDE * sin(w)));
+        }
+        return static_cast<bool>(f);
+    }
+
+    bool check(bool ok, const std::string& what)
+    {
+        std::cout << what << (ok ? ": ok" : ": FAILED") << std::endl;
+        return ok;
+    }
+
+    int test(const std::string& scratch)
+    {
+        auto scratchFile = [&scratch](const std::string& name) { return scratch.empty() ? name : scratch + "/" + name; };
+        const std::string input = scratchFile("HeadlessSDRTest_input.wav");
+        Settings settings;
+        settings.wavFile = scratchFile("HeadlessSDRTest_output.wav");
+        settings.fifo = scratchFile("HeadlessSDRTest.fifo");
+        if (!writeTestInput(input))
+        {
+            std::cerr << "Failed to write " << input << std::endl;
+            return 1;
+        }
+
+        Results results;
+        bool ok = run(input, settings, results);
+        const uint64_t frames = TEST_SECONDS * SimpleSdrDemodulator::get_framesPerSecond();
+        if (!check(results.null.frames == frames && results.wav.frames == frames && results.fifo.frames == frames,
+                "every sink got all the audio"))
+            ok = false;
+        if (!check(results.null.realTimeFactor > 1, "null faster than real time"))
+            ok = false;
+
+        std::ifstream wav(settings.wavFile, std::ios::binary);
+        std::vector<char> contents((std::istreambuf_iterator<char>(wav)), std::istreambuf_iterator<char>());
+        uint32_t dataBytes = 0;
+        int peak = 0;
+        if (contents.size() >= 44)
+        {
+            memcpy(&dataBytes, &contents[40], sizeof(dataBytes));
+            for (size_t i = 44; i + sizeof(short) <= contents.size(); i += sizeof(short))
+            {
+                short s;
+                memcpy(&s, &contents[i], sizeof(s));
+                peak = std::max(peak, std::abs(static_cast<int>(s)));
+            }
+        }
+        if (!check(contents.size() == 44 + frames * sizeof(short) && dataBytes == frames * sizeof(short) &&
+                peak > 0x7FFF / 8, "wav file has the tone"))
+            ok = false;
+
+        // The FIFO is written in whole 10 msec periods, and its silence after the end isn't counted
+        if (!check(results.fifo.realTimeFactor > 0.9 && results.fifo.realTimeFactor < 1.1 && !results.fifoFailed &&
+                results.fifoBytesRead >= frames * sizeof(short), "fifo at real time"))
+            ok = false;
+
+        if (ok)
+            for (const auto& f : { input, settings.wavFile, settings.fifo })
+                std::remove(f.c_str());
+        std::cout << (ok ? "All passed" : "FAILED") << std::endl;
+        return ok ? 0 : 1;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && std::string(argv[1]) == TestArg)
+    {
+        try {
+            return test(argc > 2 ? argv[2] : "");
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    std::string inputFileName;
+    Settings settings;
+    // parse command line arguments
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.find("--") != 0)
+        {
+            if (inputFileName.empty())
+                inputFileName = arg;
+            else
+                std::cerr << "Illegal command argument \"" << arg << "\"" << std::endl;
+        }
+        else if (arg.find(SinkArg) == 0)
+        {
+            settings.sinks = arg.substr(sizeof(SinkArg) - 1);
+            if (settings.sinks != "null" && settings.sinks != "wav" && settings.sinks != "fifo" && settings.sinks != "all")
+            {
+                std::cerr << "Unrecognized sink \"" << settings.sinks << "\"" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg.find(WavFileArg) == 0)
+            settings.wavFile = arg.substr(sizeof(WavFileArg) - 1);
+        else if (arg.find(FifoArg) == 0)
+            settings.fifo = arg.substr(sizeof(FifoArg) - 1);
+        else if (arg == ExternalFifoReaderArg)
+            settings.externalFifoReader = true;
+        else if (arg.find(JitterBufferArg) == 0)
+            settings.jitterBufferMsec = static_cast<unsigned>(atoi(arg.substr(sizeof(JitterBufferArg) - 1).c_str()));
+        else if (arg.find(SecondsArg) == 0)
+            settings.seconds = atof(arg.substr(sizeof(SecondsArg) - 1).c_str());
+        else if (arg.find(CenterHzArg) == 0)
+            settings.centerHz = static_cast<float>(atof(arg.substr(sizeof(CenterHzArg) - 1).c_str()));
+        else if (arg.find(WeaverHzArg) == 0)
+            settings.weaverHz = static_cast<float>(atof(arg.substr(sizeof(WeaverHzArg) - 1).c_str()));
+        else
+        {
+            std::cerr << "Unrecognized command argument: \"" << arg << "\"" << std::endl;
+            return 1;
+        }
+    }
+
+    // validate command line arguments
+    if (inputFileName.empty())
+    {
+        std::cerr << "No input file specified" << std::endl;
+        return usage();
+    }
+    const unsigned rate = SimpleSdrDemodulator::get_framesPerSecond();
+    if (std::fabs(settings.centerHz) >= rate / 2 || std::fabs(settings.weaverHz) >= rate / 2)
+    {
+        std::cerr << "The frequencies cannot be beyond " << rate / 2 << "Hz" << std::endl;
+        return 1;
+    }
+
+    try {
+        Results results;
+        return run(inputFileName, settings, results) ? 0 : 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,99 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#pragma once
+#include "AudioSink.h"
+#include <AsyncWriter.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+// AudioSink's for running SimpleSdrImpl with no sound card.
+// Each belongs to whoever creates it, and must outlive the SimpleSDR it is handed to. Its ReleaseSink
+// (which SimpleSDR calls when it closes) finishes up, and the statistics can be read after that.
+namespace XD {
+
+    // Counts the frames and times the calls, and does nothing with the audio. For measuring how much
+    // faster than real time SimpleSdrImpl runs.
+    class NullSink : public AudioSink
+    {
+    public:
+        explicit NullSink(unsigned sampleRate = 12000);
+        bool AddMonoSoundFrames(const short *p, unsigned frameCount) override;
+        void AudioComplete() override {}
+        void ReleaseSink() override {}
+
+        // These may be read while SimpleSDR is playing
+        uint64_t get_frames() const;
+        double get_seconds() const; // wall clock, from the first call to the latest one
+        double get_maxCallGapSeconds() const; // the longest wait between calls
+        double get_firstCallSeconds(std::chrono::steady_clock::time_point since) const; // from since to the first call
+        double RealTimeFactor() const; // seconds of audio per second of wall clock
+
+    protected:
+        typedef std::chrono::steady_clock steady_clock_t;
+        typedef std::unique_lock<std::mutex> lock_t;
+        const unsigned m_sampleRate;
+        uint64_t m_frames;
+        steady_clock_t::time_point m_first;
+        steady_clock_t::time_point m_latest;
+        double m_maxCallGapSeconds;
+        mutable std::mutex m_mutex;
+    };
+
+    // Writes 16 bit mono PCM WAV file, as fast as the audio comes. The file is written on a background
+    // thread (CAsyncWriter), and its header gets the final sizes in ReleaseSink.
+    class WavFileSink : public NullSink
+    {
+    public:
+        WavFileSink(const std::string &fileName, unsigned sampleRate = 12000); // throws if the file can't be created
+        ~WavFileSink();
+        bool AddMonoSoundFrames(const short *p, unsigned frameCount) override;
+        void ReleaseSink() override;
+        bool get_failed() const { return m_failed; }
+
+    private:
+        void writeHeader(uint32_t dataBytes);
+        CAsyncWriter m_writer;
+        bool m_closed;
+        bool m_failed;
+    };
+
+    // Writes raw 16 bit mono PCM (little endian) to a named pipe at the sample rate by the wall clock, as a
+    // sound card would consume it. The FIFO is created if it doesn't exist. Until a reader opens it, the
+    // audio is paced out and discarded. AddMonoSoundFrames blocks while the jitter buffer is full, which
+    // paces the SDR to real time. Where the buffer runs dry, silence is written and counted as an underrun.
+    // get_failed() is true if the reader closed its end.
+    class PacedFifoSink : public NullSink
+    {
+    public:
+        PacedFifoSink(const std::string &fifoName, unsigned sampleRate = 12000, unsigned jitterBufferMsec = 100);
+        ~PacedFifoSink();
+        bool AddMonoSoundFrames(const short *p, unsigned frameCount) override;
+        void ReleaseSink() override;
+
+        unsigned get_underruns() const;
+        double get_averageLatencySeconds() const; // how long the audio waited in the jitter buffer
+        double get_maxLatencySeconds() const;
+        bool get_failed() const;
+
+    private:
+        void thread();
+        const std::string m_fifoName;
+        const unsigned m_periodFrames; // written every 10 msec
+        std::vector<short> m_buffer; // ring of the jitter buffer
+        size_t m_head; // next to write to the FIFO
+        size_t m_count;
+        bool m_started; // once the buffer first fills to its half
+        bool m_stop;
+        bool m_failed;
+        unsigned m_underruns;
+        double m_latencySum;
+        uint64_t m_latencyCount;
+        double m_maxLatency;
+        std::condition_variable m_cond;
+        std::thread m_thread;
+    };
+}
@@ -0,0 +1,304 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#include "HeadlessAudioSinks.h"
+#include <algorithm>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/stat.h>
+
+namespace {
+    const uint32_t WAV_HEADER_BYTES = 44;
+    const unsigned PACED_PERIOD_MSEC = 10;
+
+    void put16(unsigned char* p, uint16_t v)
+    {
+        p[0] = static_cast<unsigned char>(v);
+        p[1] = static_cast<unsigned char>(v >> 8);
+    }
+
+    void put32(unsigned char* p, uint32_t v)
+    {
+        put16(p, static_cast<uint16_t>(v));
+        put16(p + 2, static_cast<uint16_t>(v >> 16));
+    }
+
+    double toSeconds(std::chrono::steady_clock::duration d)
+    {
+        return std::chrono::duration<double>(d).count();
+    }
+}
+
+namespace XD {
+
+    /*********************************************************************************************/
+    NullSink::NullSink(unsigned sampleRate)
+        : m_sampleRate(sampleRate)
+        , m_frames(0)
+        , m_maxCallGapSeconds(0)
+    {}
+
+    bool NullSink::AddMonoSoundFrames(const short *, unsigned frameCount)
+    {
+        auto now = steady_clock_t::now();
+        lock_t l(m_mutex);
+        if (m_frames == 0)
+            m_first = now;
+        else
+            m_maxCallGapSeconds = std::max(m_maxCallGapSeconds, toSeconds(now - m_latest));
+        m_latest = now;
+        m_frames += frameCount;
+        return true;
+    }
+
+    uint64_t NullSink::get_frames() const
+    {
+        lock_t l(m_mutex);
+        return m_frames;
+    }
+
+    double NullSink::get_seconds() const
+    {
+        lock_t l(m_mutex);
+        return m_frames == 0 ? 0 : toSeconds(m_latest - m_first);
+    }
+
+    double NullSink::get_maxCallGapSeconds() const
+    {
+        lock_t l(m_mutex);
+        return m_maxCallGapSeconds;
+    }
+
+    double NullSink::get_firstCallSeconds(steady_clock_t::time_point since) const
+    {
+        lock_t l(m_mutex);
+        return m_frames == 0 ? 0 : toSeconds(m_first - since);
+    }
+
+    double NullSink::RealTimeFactor() const
+    {
+        double wall = get_seconds();
+        if (wall <= 0)
+            return 0;
+        return static_cast<double>(get_frames()) / m_sampleRate / wall;
+    }
+
+    /*********************************************************************************************/
+    WavFileSink::WavFileSink(const std::string &fileName, unsigned sampleRate)
+        : NullSink(sampleRate)
+        , m_closed(false)
+        , m_failed(false)
+    {
+        if (!m_writer.Open(fileName))
+            throw std::runtime_error("Failed to open output \"" + fileName + "\"");
+        writeHeader(0); // the sizes are filled in at the end
+    }
+
+    WavFileSink::~WavFileSink()
+    {
+        ReleaseSink();
+    }
+
+    bool WavFileSink::AddMonoSoundFrames(const short *p, unsigned frameCount)
+    {
+        NullSink::AddMonoSoundFrames(p, frameCount);
+        // WAV is little endian, and so is every machine this runs on
+        m_writer.Write(p, frameCount * sizeof(short));
+        return true;
+    }
+
+    void WavFileSink::ReleaseSink()
+    {
+        if (m_closed)
+            return;
+        m_closed = true;
+        uint64_t dataBytes = get_frames() * sizeof(short);
+        writeHeader(static_cast<uint32_t>(std::min<uint64_t>(dataBytes, 0xFFFFFFFFu - WAV_HEADER_BYTES)));
+        m_failed = !m_writer.Close();
+    }
+
+    void WavFileSink::writeHeader(uint32_t dataBytes)
+    {
+        const uint16_t blockAlign = sizeof(short); // mono
+        unsigned char h[WAV_HEADER_BYTES];
+        memcpy(h, "RIFF", 4);
+        put32(h + 4, WAV_HEADER_BYTES - 8 + dataBytes);
+        memcpy(h + 8, "WAVEfmt ", 8);
+        put32(h + 16, 16); // fmt chunk size
+        put16(h + 20, 1); // PCM
+        put16(h + 22, 1); // mono
+        put32(h + 24, m_sampleRate);
+        put32(h + 28, m_sampleRate * blockAlign);
+        put16(h + 32, blockAlign);
+        put16(h + 34, 8 * sizeof(short));
+        memcpy(h + 36, "data", 4);
+        put32(h + 40, dataBytes);
+        uint64_t position = m_writer.get_position();
+        m_writer.Seek(0);
+        m_writer.Write(h, sizeof(h));
+        if (position > sizeof(h))
+            m_writer.Seek(position);
+    }
+
+    /*********************************************************************************************/
+    PacedFifoSink::PacedFifoSink(const std::string &fifoName, unsigned sampleRate, unsigned jitterBufferMsec)
+        : NullSink(sampleRate)
+        , m_fifoName(fifoName)
+        , m_periodFrames(std::max(1u, sampleRate * PACED_PERIOD_MSEC / 1000))
+        , m_buffer(std::max(2 * m_periodFrames, sampleRate * jitterBufferMsec / 1000))
+        , m_head(0)
+        , m_count(0)
+        , m_started(false)
+        , m_stop(false)
+        , m_failed(false)
+        , m_underruns(0)
+        , m_latencySum(0)
+        , m_latencyCount(0)
+        , m_maxLatency(0)
+    {
+        struct stat st;
+        if (stat(fifoName.c_str(), &st) != 0 && mkfifo(fifoName.c_str(), 0666) != 0)
+            throw std::runtime_error("Failed to create FIFO \"" + fifoName + "\"");
+        m_thread = std::thread(&PacedFifoSink::thread, this);
+    }
+
+    PacedFifoSink::~PacedFifoSink()
+    {
+        ReleaseSink();
+    }
+
+    bool PacedFifoSink::AddMonoSoundFrames(const short *p, unsigned frameCount)
+    {
+        NullSink::AddMonoSoundFrames(p, frameCount);
+        lock_t l(m_mutex);
+        while (frameCount > 0)
+        {
+            while (!m_stop && m_count == m_buffer.size())
+                m_cond.wait(l);
+            if (m_stop)
+                return false;
+            // What is already in the buffer is written ahead of these
+            double latency = static_cast<double>(m_count) / m_sampleRate;
+            m_latencySum += latency;
+            m_latencyCount += 1;
+            m_maxLatency = std::max(m_maxLatency, latency);
+            while (frameCount > 0 && m_count < m_buffer.size())
+            {
+                m_buffer[(m_head + m_count) % m_buffer.size()] = *p++;
+                m_count += 1;
+                frameCount -= 1;
+            }
+            if (m_count >= m_buffer.size() / 2)
+                m_started = true;
+            m_cond.notify_all();
+        }
+        return true;
+    }
+
+    void PacedFifoSink::ReleaseSink()
+    {
+        if (!m_thread.joinable())
+            return;
+        {
+            lock_t l(m_mutex);
+            m_stop = true;
+            m_cond.notify_all();
+        }
+        m_thread.join();
+    }
+
+    unsigned PacedFifoSink::get_underruns() const
+    {
+        lock_t l(m_mutex);
+        return m_underruns;
+    }
+
+    double PacedFifoSink::get_averageLatencySeconds() const
+    {
+        lock_t l(m_mutex);
+        return m_latencyCount == 0 ? 0 : m_latencySum / m_latencyCount;
+    }
+
+    double PacedFifoSink::get_maxLatencySeconds() const
+    {
+        lock_t l(m_mutex);
+        return m_maxLatency;
+    }
+
+    bool PacedFifoSink::get_failed() const
+    {
+        lock_t l(m_mutex);
+        return m_failed;
+    }
+
+    void PacedFifoSink::thread()
+    {
+        // A reader that goes away makes write() fail with EPIPE, rather than kill the process.
+        sigset_t pipe;
+        sigemptyset(&pipe);
+        sigaddset(&pipe, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipe, nullptr);
+
+        int fd = -1;
+        std::vector<short> period(m_periodFrames);
+        lock_t l(m_mutex);
+        while (!m_stop && !m_started)
+            m_cond.wait(l);
+        // Each period is written at its place on the clock from here, so the pace doesn't drift
+        auto next = steady_clock_t::now();
+        while (!m_stop || m_count > 0)
+        {
+            unsigned n = static_cast<unsigned>(std::min<size_t>(m_count, m_periodFrames));
+            for (unsigned i = 0; i < n; i++)
+                period[i] = m_buffer[(m_head + i) % m_buffer.size()];
+            m_head = (m_head + n) % m_buffer.size();
+            m_count -= n;
+            if (n < m_periodFrames)
+            {
+                std::fill(period.begin() + n, period.end(), 0);
+                if (!m_stop)
+                    m_underruns += 1;
+            }
+            m_cond.notify_all();
+            l.unlock();
+
+            // Opening a FIFO to write fails until it has a reader. Until then, the audio is paced
+            // out just the same, to nowhere, as a sound card with nothing plugged in.
+            if (fd < 0)
+            {
+                fd = open(m_fifoName.c_str(), O_WRONLY | O_NONBLOCK);
+                if (fd >= 0)
+                    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+            }
+            bool ok = true;
+            const char* q = reinterpret_cast<const char*>(&period[0]);
+            size_t bytes = period.size() * sizeof(short);
+            while (fd >= 0 && ok && bytes > 0)
+            {
+                ssize_t w = write(fd, q, bytes);
+                if (w < 0 && errno == EINTR)
+                    continue;
+                ok = w > 0;
+                if (ok)
+                {
+                    q += w;
+                    bytes -= static_cast<size_t>(w);
+                }
+            }
+            next += std::chrono::milliseconds(PACED_PERIOD_MSEC);
+            std::this_thread::sleep_until(next);
+            l.lock();
+            if (!ok)
+            {   // the reader went away. The rest is discarded
+                m_failed = true;
+                m_stop = true;
+                m_count = 0;
+                m_cond.notify_all();
+            }
+        }
+        if (fd >= 0)
+            close(fd);
+    }
+}
@@ -50,10 +50,13 @@ namespace ReviewRecordedIQ
             this.timer1 = new System.Windows.Forms.Timer(this.components);
             this.buttonForward = new System.Windows.Forms.Button();
             this.buttonBack = new System.Windows.Forms.Button();
+            this.trackBarWindow = new System.Windows.Forms.TrackBar();
+            this.labelWindow = new System.Windows.Forms.Label();
             ((System.ComponentModel.ISupportInitialize)(this.trackBarTune)).BeginInit();
             ((System.ComponentModel.ISupportInitialize)(this.trackBarBfo)).BeginInit();
             this.groupBoxPresets.SuspendLayout();
             ((System.ComponentModel.ISupportInitialize)(this.trackBarPlayPosition)).BeginInit();
+            ((System.ComponentModel.ISupportInitialize)(this.trackBarWindow)).BeginInit();
             this.SuspendLayout();
             // 
             // comboBoxWaveOut
@@ -254,11 +257,34 @@ namespace ReviewRecordedIQ
             this.buttonBack.UseVisualStyleBackColor = true;
             this.buttonBack.Click += new System.EventHandler(this.buttonBack_Click);
             // 
+            // trackBarWindow
+            // 
+            this.trackBarWindow.Enabled = false;
+            this.trackBarWindow.Location = new System.Drawing.Point(299, 300);
+            this.trackBarWindow.Maximum = 100000;
+            this.trackBarWindow.Minimum = -100000;
+            this.trackBarWindow.Name = "trackBarWindow";
+            this.trackBarWindow.Size = new System.Drawing.Size(244, 45);
+            this.trackBarWindow.TabIndex = 16;
+            this.trackBarWindow.TickFrequency = 6000;
+            this.trackBarWindow.ValueChanged += new System.EventHandler(this.trackBarWindow_ValueChanged);
+            // 
+            // labelWindow
+            // 
+            this.labelWindow.AutoSize = true;
+            this.labelWindow.Location = new System.Drawing.Point(406, 338);
+            this.labelWindow.Name = "labelWindow";
+            this.labelWindow.Size = new System.Drawing.Size(68, 13);
+            this.labelWindow.TabIndex = 17;
+            this.labelWindow.Text = "labelWindow";
+            // 
             // MainForm
             // 
             this.AutoScaleDimensions = new System.Drawing.SizeF(6F, 13F);
             this.AutoScaleMode = System.Windows.Forms.AutoScaleMode.Font;
-            this.ClientSize = new System.Drawing.Size(608, 304);
+            this.ClientSize = new System.Drawing.Size(608, 362);
+            this.Controls.Add(this.labelWindow);
+            this.Controls.Add(this.trackBarWindow);
             this.Controls.Add(this.buttonBack);
             this.Controls.Add(this.buttonForward);
             this.Controls.Add(this.trackBarPlayPosition);
@@ -285,6 +311,7 @@ namespace ReviewRecordedIQ
             this.groupBoxPresets.ResumeLayout(false);
             this.groupBoxPresets.PerformLayout();
             ((System.ComponentModel.ISupportInitialize)(this.trackBarPlayPosition)).EndInit();
+            ((System.ComponentModel.ISupportInitialize)(this.trackBarWindow)).EndInit();
             this.ResumeLayout(false);
             this.PerformLayout();
 
@@ -312,6 +339,8 @@ namespace ReviewRecordedIQ
         private System.Windows.Forms.Timer timer1;
         private System.Windows.Forms.Button buttonForward;
         private System.Windows.Forms.Button buttonBack;
+        private System.Windows.Forms.TrackBar trackBarWindow;
+        private System.Windows.Forms.Label labelWindow;
     }
 }
 
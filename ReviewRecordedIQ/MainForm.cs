@@ -38,6 +38,7 @@ namespace ReviewRecordedIQ
             labelCenter.Text = "";
             labelBfo.Text = "";
             labelFromSliceIQ.Text = "";
+            labelWindow.Text = "";
             buttonPause.Enabled = buttonPlay.Enabled;
             radioButtonUSB.Checked = true;
         }
@@ -57,8 +58,9 @@ namespace ReviewRecordedIQ
         private void buttonFile_Click(object sender, EventArgs e)
         {
             var fd = new OpenFileDialog();
-            fd.Title = "Select .WAV file from SliceIQ";
+            fd.Title = "Select .WAV file from SliceIQ (or all the files of a split recording)";
             fd.Filter = "Wave Files (*.wav)|*.wav";
+            fd.Multiselect = true;
             if (fd.ShowDialog() == DialogResult.OK)
             {
                 SliceIQCenterKHz = 0;
@@ -68,7 +70,7 @@ namespace ReviewRecordedIQ
                 deviceTx.ThrottleSource = true;
                 deviceTx.Open((uint)selectedDevice, 2);
 
-                sdr = new XDSdr.SimpleSDR(fd.FileName, deviceTx.GetRealTimeAudioSink());
+                sdr = new XDSdr.SimpleSDR(fd.FileNames, deviceTx.GetRealTimeAudioSink());
                 buttonPlay.Enabled = true;
                 buttonPause.Enabled = buttonPlay.Enabled;
                 var maxHz = sdr.IfBoundaryAbsHz;
@@ -81,6 +83,14 @@ namespace ReviewRecordedIQ
                 sdr.RxFrequencyBfoOffsetHz = trackBarBfo.Value;
                 sdr.Bandwidth = (XDSdr.SdrDecodeBandwidth)(comboBoxBandwidth.SelectedIndex);
 
+                // A recording faster than 12KHz plays through a 12KHz window of it, which can be moved
+                // up to WindowBoundaryAbsHz either side of its center. A new SDR's window is centered.
+                var windowHz = sdr.WindowBoundaryAbsHz;
+                trackBarWindow.Value = 0;
+                trackBarWindow.Minimum = (int)-windowHz;
+                trackBarWindow.Maximum = (int)windowHz;
+                trackBarWindow.Enabled = windowHz > 0;
+
                 labelCenter.Text = String.Format("Center decode = {0} KHz", sdr.RxFrequencyCenterHz * .001);
                 labelBfo.Text = String.Format("Weaver decode = {0} KHz", sdr.RxFrequencyBfoOffsetHz * .001);
 
@@ -155,6 +165,15 @@ namespace ReviewRecordedIQ
             UpdateDialFrequency();
         }
 
+        private void trackBarWindow_ValueChanged(object sender, EventArgs e)
+        {
+            if (sdr != null)
+            {
+                sdr.WindowCenterHz = trackBarWindow.Value;
+            }
+            UpdateDialFrequency();
+        }
+
         private void trackBarTune_ValueChanged(object sender, EventArgs e)
         {
             if (sdr != null)
@@ -184,12 +203,16 @@ namespace ReviewRecordedIQ
 
         private double tuneFrequencyKHz(int bfo = 0)
         {
-            return SliceIQCenterKHz + (trackBarTune.Value + bfo) * .001;
+            return SliceIQCenterKHz + (trackBarWindow.Value + trackBarTune.Value + bfo) * .001;
         }
 
         private void UpdateDialFrequency()
         {
-            labelCenter.Text = String.Format("Center of filter = {0} KHz", SliceIQCenterKHz + trackBarTune.Value * .001);
+            labelCenter.Text = String.Format("Center of filter = {0} KHz", tuneFrequencyKHz());
+            if (trackBarWindow.Enabled)
+                labelWindow.Text = String.Format("Window center = {0} KHz", SliceIQCenterKHz + trackBarWindow.Value * .001);
+            else
+                labelWindow.Text = "";
             if (radioButtonCW.Checked)
             {
                 labelDialFreq.Text = String.Format("CW at {0} KHz, Pitch={1} ({2})",
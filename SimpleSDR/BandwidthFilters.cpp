@@ -0,0 +1,459 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#include "BandwidthFilters.h"
+
+/*************************************************************************************************
+** Filters ***************************************************************************************
+* These are all designed with octave: http://www.octave.org
+*************************************************************************************************/
+
+namespace NARROW_CW_FILTER {
+/*  Octave:
+    f = 125 / 12000
+    b = fir1(100, f)
+    freqz(b)
+    fd = fopen("d:/temp/250of6000.txt", "w")
+    fprintf(fd, "%10g,\n", b)
+    fclose(fd)
+*/
+    FilterCoeficient_t filter_taps[SAMPLEFILTER_TAP_NUM] = { 1.33275e-05,
+5.24769e-05,
+9.6034e-05,
+0.000146771,
+0.000207588,
+0.000281477,
+0.000371482,
+0.000480656,
+0.000612018,
+0.00076851,
+0.000952954,
+0.00116801,
+0.00141611,
+0.00169948,
+0.00202002,
+0.00237931,
+0.00277859,
+0.00321871,
+0.00370009,
+0.00422273,
+0.00478618,
+0.00538952,
+0.00603137,
+0.00670988,
+0.00742273,
+0.00816715,
+0.00893995,
+ 0.0097375,
+ 0.0105558,
+ 0.0113905,
+ 0.0122368,
+ 0.0130899,
+ 0.0139446,
+ 0.0147953,
+ 0.0156367,
+ 0.0164631,
+  0.017269,
+ 0.0180485,
+ 0.0187964,
+ 0.0195071,
+ 0.0201755,
+ 0.0207966,
+ 0.0213659,
+ 0.0218789,
+ 0.0223318,
+ 0.0227212,
+ 0.0230439,
+ 0.0232976,
+ 0.0234803,
+ 0.0235904,
+ 0.0236272,
+ 0.0235904,
+ 0.0234803,
+ 0.0232976,
+ 0.0230439,
+ 0.0227212,
+ 0.0223318,
+ 0.0218789,
+ 0.0213659,
+ 0.0207966,
+ 0.0201755,
+ 0.0195071,
+ 0.0187964,
+ 0.0180485,
+  0.017269,
+ 0.0164631,
+ 0.0156367,
+ 0.0147953,
+ 0.0139446,
+ 0.0130899,
+ 0.0122368,
+ 0.0113905,
+ 0.0105558,
+ 0.0097375,
+0.00893995,
+0.00816715,
+0.00742273,
+0.00670988,
+0.00603137,
+0.00538952,
+0.00478618,
+0.00422273,
+0.00370009,
+0.00321871,
+0.00277859,
+0.00237931,
+0.00202002,
+0.00169948,
+0.00141611,
+0.00116801,
+0.000952954,
+0.00076851,
+0.000612018,
+0.000480656,
+0.000371482,
+0.000281477,
+0.000207588,
+0.000146771,
+9.6034e-05,
+5.24769e-05,
+1.33275e-05,
+    };
+}
+namespace WIDE_CW_FILTER {
+    /*  Octave:
+        f = 250/12000
+        b = fir1(100,f)
+        freqz(b)
+        fd=fopen("d:/temp/CW500.txt", "w")
+        fprintf(fd, "%10g,\n", b)
+        fclose(fd)    
+        */
+    FilterCoeficient_t filter_taps[SAMPLEFILTER_TAP_NUM] ={
+1.33275e-05,
+5.24769e-05,
+9.6034e-05,
+0.000146771,
+0.000207588,
+0.000281477,
+0.000371482,
+0.000480656,
+0.000612018,
+0.00076851,
+0.000952954,
+0.00116801,
+0.00141611,
+0.00169948,
+0.00202002,
+0.00237931,
+0.00277859,
+0.00321871,
+0.00370009,
+0.00422273,
+0.00478618,
+0.00538952,
+0.00603137,
+0.00670988,
+0.00742273,
+0.00816715,
+0.00893995,
+ 0.0097375,
+ 0.0105558,
+ 0.0113905,
+ 0.0122368,
+ 0.0130899,
+ 0.0139446,
+ 0.0147953,
+ 0.0156367,
+ 0.0164631,
+  0.017269,
+ 0.0180485,
+ 0.0187964,
+ 0.0195071,
+ 0.0201755,
+ 0.0207966,
+ 0.0213659,
+ 0.0218789,
+ 0.0223318,
+ 0.0227212,
+ 0.0230439,
+ 0.0232976,
+ 0.0234803,
+ 0.0235904,
+ 0.0236272,
+ 0.0235904,
+ 0.0234803,
+ 0.0232976,
+ 0.0230439,
+ 0.0227212,
+ 0.0223318,
+ 0.0218789,
+ 0.0213659,
+ 0.0207966,
+ 0.0201755,
+ 0.0195071,
+ 0.0187964,
+ 0.0180485,
+  0.017269,
+ 0.0164631,
+ 0.0156367,
+ 0.0147953,
+ 0.0139446,
+ 0.0130899,
+ 0.0122368,
+ 0.0113905,
+ 0.0105558,
+ 0.0097375,
+0.00893995,
+0.00816715,
+0.00742273,
+0.00670988,
+0.00603137,
+0.00538952,
+0.00478618,
+0.00422273,
+0.00370009,
+0.00321871,
+0.00277859,
+0.00237931,
+0.00202002,
+0.00169948,
+0.00141611,
+0.00116801,
+0.000952954,
+0.00076851,
+0.000612018,
+0.000480656,
+0.000371482,
+0.000281477,
+0.000207588,
+0.000146771,
+9.6034e-05,
+5.24769e-05,
+1.33275e-05,
+    };
+}
+namespace NARROW_SSB_FILTER {
+    /*  Octave:
+        f = 1020/12000
+        b = fir1(100,f)
+        fd=fopen("d:/temp/SSB2040.txt", "w")
+        fprintf(fd, "%10g,\n", b)
+        fclose(fd)
+        */
+    FilterCoeficient_t filter_taps[SAMPLEFILTER_TAP_NUM] = 
+    {
+0.000299054,
+0.000188022,
+5.73147e-05,
+-9.45361e-05,
+-0.000267475,
+-0.000458224,
+-0.000658816,
+-0.000855647,
+-0.00102931,
+-0.0011554,
+-0.00120632,
+-0.00115407,
+-0.000973822,
+-0.00064789,
+-0.000169779,
+0.000452272,
+0.00119269,
+0.00200744,
+0.00283464,
+0.00359726,
+0.00420787,
+ 0.0045753,
+0.00461276,
+0.00424705,
+0.00342781,
+0.00213626,
+0.000392428,
+-0.00173999,
+-0.00415175,
+-0.00668977,
+-0.00916253,
+-0.0113493,
+-0.0130124,
+-0.0139128,
+-0.0138265,
+ -0.012562,
+-0.00997698,
+-0.00599262,
+-0.000604795,
+0.00610914,
+ 0.0139888,
+ 0.0227944,
+ 0.0322168,
+ 0.0418914,
+ 0.0514174,
+ 0.0603798,
+ 0.0683734,
+ 0.0750261,
+  0.080022,
+ 0.0831202,
+ 0.0841701,
+ 0.0831202,
+  0.080022,
+ 0.0750261,
+ 0.0683734,
+ 0.0603798,
+ 0.0514174,
+ 0.0418914,
+ 0.0322168,
+ 0.0227944,
+ 0.0139888,
+0.00610914,
+-0.000604795,
+-0.00599262,
+-0.00997698,
+ -0.012562,
+-0.0138265,
+-0.0139128,
+-0.0130124,
+-0.0113493,
+-0.00916253,
+-0.00668977,
+-0.00415175,
+-0.00173999,
+0.000392428,
+0.00213626,
+0.00342781,
+0.00424705,
+0.00461276,
+ 0.0045753,
+0.00420787,
+0.00359726,
+0.00283464,
+0.00200744,
+0.00119269,
+0.000452272,
+-0.000169779,
+-0.00064789,
+-0.000973822,
+-0.00115407,
+-0.00120632,
+-0.0011554,
+-0.00102931,
+-0.000855647,
+-0.000658816,
+-0.000458224,
+-0.000267475,
+-9.45361e-05,
+5.73147e-05,
+0.000188022,
+0.000299054,
+    };
+}
+namespace WIDE_SSB_FILTER {
+    /*  Octave:
+        f = 1200/12000
+        b = fir1(100,f)
+        freqz(b)
+        fd = fopen("d:/temp/2400of6000.txt", "w")
+        fprintf(fd, "%10g,\n", b)
+        fclose(fd)
+    */
+    FilterCoeficient_t filter_taps[SAMPLEFILTER_TAP_NUM] = { 
+-7.74788e-05,
+-0.000367152,
+-0.00054399,
+-0.000532634,
+-0.000304421,
+9.94694e-05,
+0.000559382,
+0.000897583,
+0.00093385,
+0.000564832,
+-0.00016314,
+-0.00102717,
+-0.00167654,
+-0.00175765,
+-0.00107753,
+0.000262436,
+0.00183457,
+0.00299675,
+0.00313153,
+0.00193186,
+-0.000387748,
+-0.00306799,
+-0.00502119,
+-0.00524086,
+-0.00326123,
+0.000526855,
+0.00487117,
+0.00802679,
+0.00840902,
+0.00530257,
+-0.00066613,
+-0.00753681,
+-0.0125862,
+-0.0133231,
+-0.00857107,
+0.000791895,
+ 0.0117942,
+ 0.0201706,
+ 0.0218272,
+  0.014515,
+-0.000891776,
+-0.0200518,
+  -0.03601,
+-0.0411124,
+-0.0294477,
+0.000955936,
+ 0.0469428,
+  0.100533,
+   0.15074,
+  0.186421,
+  0.199326,
+  0.186421,
+   0.15074,
+  0.100533,
+ 0.0469428,
+0.000955936,
+-0.0294477,
+-0.0411124,
+  -0.03601,
+-0.0200518,
+-0.000891776,
+  0.014515,
+ 0.0218272,
+ 0.0201706,
+ 0.0117942,
+0.000791895,
+-0.00857107,
+-0.0133231,
+-0.0125862,
+-0.00753681,
+-0.00066613,
+0.00530257,
+0.00840902,
+0.00802679,
+0.00487117,
+0.000526855,
+-0.00326123,
+-0.00524086,
+-0.00502119,
+-0.00306799,
+-0.000387748,
+0.00193186,
+0.00313153,
+0.00299675,
+0.00183457,
+0.000262436,
+-0.00107753,
+-0.00175765,
+-0.00167654,
+-0.00102717,
+-0.00016314,
+0.000564832,
+0.00093385,
+0.000897583,
+0.000559382,
+9.94694e-05,
+-0.000304421,
+-0.000532634,
+-0.00054399,
+-0.000367152,
+-7.74788e-05,
+    };
+}
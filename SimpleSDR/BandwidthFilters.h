@@ -0,0 +1,21 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#pragma once
+#include <FIRFilter.h>
+
+// SimpleSdrImpl's four audio bandwidths, at 12KHz.
+namespace NARROW_CW_FILTER {
+    const unsigned SAMPLEFILTER_TAP_NUM = 101;
+    extern FilterCoeficient_t filter_taps[];
+}
+namespace WIDE_CW_FILTER {
+    const unsigned SAMPLEFILTER_TAP_NUM = 101;
+    extern FilterCoeficient_t filter_taps[];
+}
+namespace NARROW_SSB_FILTER {
+    const unsigned SAMPLEFILTER_TAP_NUM = 101;
+    extern FilterCoeficient_t filter_taps[];
+}
+namespace WIDE_SSB_FILTER {
+    const unsigned SAMPLEFILTER_TAP_NUM = 101;
+    extern FilterCoeficient_t filter_taps[];
+}
@@ -16,6 +16,22 @@ namespace XDSdr {
         }
     }
 
+    SimpleSDR::SimpleSDR(array<System::String^>^ SourceFiles, System::IntPtr audioSink)
+    {
+        if (audioSink.ToPointer() == 0)
+            throw gcnew System::Exception("SimpleSDR requires an Audio Sink");
+        std::vector<std::string> fileNames;
+        for each (System::String ^ f in SourceFiles)
+            fileNames.push_back(msclr::interop::marshal_as<std::string>(f));
+        try {
+            m_impl = new impl::SimpleSDR(fileNames, audioSink.ToPointer());
+        }
+        catch (std::exception& e)
+        {
+            throw gcnew System::Exception(gcnew System::String(e.what()));
+        }
+    }
+
     SimpleSDR::~SimpleSDR()
     {        this->!SimpleSDR();    }
 
@@ -50,6 +66,21 @@ namespace XDSdr {
         return m_impl->GetIfBoundaryAbsHz();
     }
 
+    float SimpleSDR::WindowBoundaryAbsHz::get()
+    {
+        return m_impl->GetWindowBoundaryAbsHz();
+    }
+
+    float SimpleSDR::WindowCenterHz::get()
+    {
+        return m_impl->GetWindowCenterHz();
+    }
+
+    void SimpleSDR::WindowCenterHz::set(float v)
+    {
+        return m_impl->SetWindowCenterHz(v);
+    }
+
     float SimpleSDR::PlayPositionSeconds::get()
     {
         return m_impl->GetPlayPositionSeconds();
@@ -94,4 +125,36 @@ namespace XDSdr {
         return msclr::interop::marshal_as<System::String^>(m_impl->FromSliceIQ());
     }
 
+    System::String^ SimpleSDR::PipelineStatistics::get()
+    {
+        return msclr::interop::marshal_as<System::String^>(m_impl->GetPipelineStatistics());
+    }
+
+    int SimpleSDR::AddReceiver(System::IntPtr audioSink)
+    {
+        if (audioSink.ToPointer() == 0)
+            throw gcnew System::Exception("AddReceiver requires an Audio Sink");
+        return m_impl->AddReceiver(audioSink.ToPointer());
+    }
+
+    void SimpleSDR::RemoveReceiver(int receiver)
+    {
+        m_impl->RemoveReceiver(receiver);
+    }
+
+    void SimpleSDR::SetReceiverRxFrequencyCenterHz(int receiver, float v)
+    {
+        m_impl->SetReceiverRxFrequencyCenterHz(receiver, v);
+    }
+
+    void SimpleSDR::SetReceiverRxFrequencyBfoOffsetHz(int receiver, float v)
+    {
+        m_impl->SetReceiverRxFrequencyBfoOffsetHz(receiver, v);
+    }
+
+    void SimpleSDR::SetReceiverBandwidth(int receiver, SdrDecodeBandwidth v)
+    {
+        m_impl->SetReceiverBandwidth(receiver, static_cast<impl::SimpleSDR::SdrDecodeBandwidth>(static_cast<int>(v)));
+    }
+
 }
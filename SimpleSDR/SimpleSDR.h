@@ -9,17 +9,29 @@ namespace XDSdr {
     {
     public:
         SimpleSDR(System::String^ sourceFile, System::IntPtr audioSink);
+        // A recording split across several files, played as one, in the order of their start times.
+        SimpleSDR(array<System::String^>^ sourceFiles, System::IntPtr audioSink);
         ~SimpleSDR();
         !SimpleSDR();
         void Play();
         void Pause();
         property float PlayLengthSeconds { float get(); }
         property float IfBoundaryAbsHz { float get(); }
+        // For a recording faster than 12000 frames per second: where the 12KHz wide window the receivers tune in is
+        property float WindowBoundaryAbsHz { float get(); }
+        property float WindowCenterHz { float get(); void set(float); }
         property float PlayPositionSeconds { float get(); void set(float); }
         property float RxFrequencyCenterHz { float get(); void set(float); }
         property float RxFrequencyBfoOffsetHz {float get(); void set(float); }
         property System::String^ FromSliceIQ { System::String ^get();}
+        property System::String^ PipelineStatistics { System::String ^get();}
         property SdrDecodeBandwidth Bandwidth { SdrDecodeBandwidth get(); void set(SdrDecodeBandwidth); }
+        // More receivers of the same file, each playing to its own audio sink. The properties above tune receiver 0.
+        int AddReceiver(System::IntPtr audioSink);
+        void RemoveReceiver(int receiver);
+        void SetReceiverRxFrequencyCenterHz(int receiver, float);
+        void SetReceiverRxFrequencyBfoOffsetHz(int receiver, float);
+        void SetReceiverBandwidth(int receiver, SdrDecodeBandwidth);
         void Close();
     private:
         impl::SimpleSDR* m_impl;
@@ -1,87 +1,488 @@
 /* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
 
 /* An entire SDR implementation in (almost) a single source file. 
-*  The filter and precompute sine/cosine are the other sources.
+*  The Filters folder and BandwidthFilters.cpp are the other sources.
 */
 
 #include "SimpleSdrImpl.h"
 #include <AudioSink.h>
-#include <RiffReader.h>
+#include <RiffSequence.h>
 #include <FIRFilter.h>
-#include <PrecomputeSinCos.h>
-#include <deque>
+#include <Nco.h>
+#include <SpscRing.h>
+#include <HalfbandDecimator.h>
+#include "BandwidthFilters.h"
+#include <atomic>
 #include <mutex>
 #include <thread>
 #include <condition_variable>
 #include <fstream>
 #include <cstring>
-
-namespace NARROW_CW_FILTER {
-    const unsigned SAMPLEFILTER_TAP_NUM = 101;
-    extern FilterCoeficient_t filter_taps[];
-}
-namespace WIDE_CW_FILTER {
-    const unsigned SAMPLEFILTER_TAP_NUM = 101;
-    extern FilterCoeficient_t filter_taps[];
-}
-namespace NARROW_SSB_FILTER {
-    const unsigned SAMPLEFILTER_TAP_NUM = 101;
-    extern FilterCoeficient_t filter_taps[];
-}
-namespace WIDE_SSB_FILTER {
-    const unsigned SAMPLEFILTER_TAP_NUM = 101;
-    extern FilterCoeficient_t filter_taps[];
-}
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
 
 namespace XDSdr {
     namespace impl {
 
         const unsigned IQ_AND_OUTPUT_FRAMES_PER_SECOND = 12000;
-        const unsigned PRECOMPUTE_SIN_COS_DENSITY = 2; // double the resolution of the table
+        const unsigned MAX_FRAMES_TO_PROCESS = 120; // 10 msec
+        const unsigned IQ_BLOCKS_QUEUED = 32; // the reader may be up to this many blocks ahead of the DSP
+        const unsigned AUDIO_BLOCKS_QUEUED = 4; // and the DSP this many ahead of the sink. Retunes are heard after these
+        const unsigned RECEIVERS_PER_DSP_THREAD = 4; // fewer receivers aren't worth waking another thread for
+        // For a recording faster than IQ_AND_OUTPUT_FRAMES_PER_SECOND
+        const unsigned IQ_CACHE_SECONDS = 60; // of decimated I/Q kept, to seek back into
+        const unsigned WINDOW_WARMUP_FRAMES = 256; // decimated on a seek, and discarded. More than the filters hold
 
-        class SimpleSDRImpl
+#if defined(SIMPLESDR_ASSERT_NO_ALLOC)
+        // Debug aid. Build with SIMPLESDR_ASSERT_NO_ALLOC defined, and any heap allocation made by
+        // the DSP while it is turning a block of I/Q into audio asserts. (See the operator new below.)
+        thread_local bool t_assertNoAllocation = false;
+        struct NoAllocationScope {
+            NoAllocationScope() { t_assertNoAllocation = true; }
+            ~NoAllocationScope() { t_assertNoAllocation = false; }
+        };
+#else
+        struct NoAllocationScope { // user-provided, so declaring one is not an unused variable
+            NoAllocationScope() {}
+            ~NoAllocationScope() {}
+        };
+#endif
+
+        // The DSP: the mix of the I/Q to baseband, the band pass filters, and the Weaver mix to audio.
+        // SimpleSDRImpl plays through one, and SimpleSdrDemodulator is one for use without playing.
+        class SdrChain
         {
         public:
-            SimpleSDRImpl(const std::string &fileName, 
-                void *sink) // The audioSink void pointer drill accomodates passing pointers between .NET objects.
-                : m_bandwidth(SimpleSDR::UNINITIALIZED)
+            SdrChain()
+                : m_bandPassFilters(2)
+                , m_mixedI(MAX_FRAMES_TO_PROCESS)
+                , m_mixedQ(MAX_FRAMES_TO_PROCESS)
+                , m_filteredI(MAX_FRAMES_TO_PROCESS)
+                , m_filteredQ(MAX_FRAMES_TO_PROCESS)
+                , m_oscillatorCos(MAX_FRAMES_TO_PROCESS)
+                , m_oscillatorSin(MAX_FRAMES_TO_PROCESS)
+                , m_mix(IQ_AND_OUTPUT_FRAMES_PER_SECOND)
+                , m_weaver(IQ_AND_OUTPUT_FRAMES_PER_SECOND)
+            {}
+
+            // The oscillators keep their phase, so the audio is continuous across a change
+            void SetMixFrequency(double hz) { m_mix.SetFrequency(-hz); }
+            void SetWeaverFrequency(double hz) { m_weaver.SetFrequency(-hz); }
+
+            void SkipFrames(uint64_t numFrames)
+            {
+                m_mix.Skip(static_cast<int64_t>(numFrames));
+                m_weaver.Skip(static_cast<int64_t>(numFrames));
+            }
+
+            void SetBandwidth(SimpleSDR::SdrDecodeBandwidth v)
+            {
+                unsigned len; const FilterCoeficient_t*coef;
+                switch (v)
+                {
+                case SimpleSDR::NARROW_CW:
+                    len = NARROW_CW_FILTER::SAMPLEFILTER_TAP_NUM;
+                    coef = NARROW_CW_FILTER::filter_taps;
+                    break;
+                case SimpleSDR::WIDE_CW:
+                    len = WIDE_CW_FILTER::SAMPLEFILTER_TAP_NUM;
+                    coef = WIDE_CW_FILTER::filter_taps;
+                    break;
+                case SimpleSDR::NARROW_SSB:
+                    len = NARROW_SSB_FILTER::SAMPLEFILTER_TAP_NUM;
+                    coef = NARROW_SSB_FILTER::filter_taps;
+                    break;
+                case SimpleSDR::WIDE_SSB:
+                    len = WIDE_SSB_FILTER::SAMPLEFILTER_TAP_NUM;
+                    coef = WIDE_SSB_FILTER::filter_taps;
+                    break;
+                default:
+                    return;
+                }
+                for (auto &f : m_bandPassFilters)
+                    f.setFilterDefinition(len, coef);
+            }
+
+            // numFrames may be up to MAX_FRAMES_TO_PROCESS
+            void ApplyMIX(const float* p, unsigned numFrames /*I/Q frames*/, float *audio)
+            {
+                if (numFrames == 0)
+                    return;
+                m_mix.Generate(&m_oscillatorCos[0], &m_oscillatorSin[0], numFrames);
+                for (unsigned i = 0; i < numFrames; i += 1)
+                {
+                    float inI = *p++;
+                    float inQ = *p++;
+
+                    double mixI = m_oscillatorCos[i];
+                    double mixQ = m_oscillatorSin[i];
+
+                    // The mix is a complex multiply
+                    m_mixedI[i] = static_cast<float>(inI * mixI - inQ * mixQ);
+                    m_mixedQ[i] = static_cast<float>(inQ * mixI + inI * mixQ);
+                }
+
+                // low pass the mixed I separate from the mixed Q, the whole block at once
+                m_bandPassFilters[0].applyBlock(&m_mixedI[0], numFrames, &m_filteredI[0]);
+                m_bandPassFilters[1].applyBlock(&m_mixedQ[0], numFrames, &m_filteredQ[0]);
+
+                // Now mix again. This time by the Weaver frequency
+                // http://www.csun.edu/~skatz/katzpage/sdr_project/sdr/ssb_rcv_signals.pdf
+                m_weaver.Generate(&m_oscillatorCos[0], &m_oscillatorSin[0], numFrames);
+                for (unsigned i = 0; i < numFrames; i += 1)
+                {
+                    // ...The sum of the I+Q detects Weaver
+                    double v = m_filteredI[i] * m_oscillatorCos[i];
+                    v += m_filteredQ[i] * m_oscillatorSin[i];
+                    audio[i] = static_cast<float>(v);
+                }
+            }
+
+        private:
+            // float is plenty for 16 bit audio, and twice as many taps fit in a SIMD register
+            std::vector<CFIRFilterFloat> m_bandPassFilters;
+            std::vector<float> m_mixedI; // ApplyMIX's scratch
+            std::vector<float> m_mixedQ;
+            std::vector<float> m_filteredI;
+            std::vector<float> m_filteredQ;
+            std::vector<double> m_oscillatorCos;
+            std::vector<double> m_oscillatorSin;
+            CNco m_mix;
+            CNco m_weaver;
+        };
+
+        // The most recent decimated I/Q, at IQ_AND_OUTPUT_FRAMES_PER_SECOND, in a ring. A seek back into
+        // it replays it instead of reading and decimating the recording again.
+        class IqCache
+        {
+        public:
+            explicit IqCache(unsigned maxFrames) : m_iq(2 * maxFrames), m_maxFrames(maxFrames), m_begin(0), m_end(0) {}
+
+            void Reset(unsigned frame) { m_begin = m_end = frame; }
+
+            void Append(float i, float q)
+            {
+                const size_t k = 2 * static_cast<size_t>(m_end % m_maxFrames);
+                m_iq[k] = i;
+                m_iq[k + 1] = q;
+                if (++m_end - m_begin > m_maxFrames)
+                    m_begin += 1; // overwrote the oldest
+            }
+
+            // frame is cached, or is the next one to be
+            bool Contains(unsigned frame) const { return frame >= m_begin && frame <= m_end; }
+            unsigned get_end() const { return m_end; }
+
+            // Copies up to numFrames, starting at frame (which Contains), to iq. Returns how many.
+            unsigned Read(unsigned frame, unsigned numFrames, float* iq) const
+            {
+                numFrames = std::min(numFrames, m_end - frame);
+                for (unsigned done = 0; done < numFrames; )
+                {
+                    const unsigned k = (frame + done) % m_maxFrames;
+                    const unsigned n = std::min(numFrames - done, m_maxFrames - k);
+                    memcpy(iq + 2 * done, &m_iq[2 * k], n * 2 * sizeof(float));
+                    done += n;
+                }
+                return numFrames;
+            }
+
+        private:
+            std::vector<float> m_iq;
+            const unsigned m_maxFrames;
+            unsigned m_begin; // the oldest frame
+            unsigned m_end; // the one after the newest
+        };
+
+        // SliceIQ's --decimator=halfband front end, so a recording made at a power of two times
+        // IQ_AND_OUTPUT_FRAMES_PER_SECOND (like the 192000 that SliceIQ takes) plays without slicing it first.
+        // It mixes a window of the recording, centered windowHz from the recording's center, to zero, and
+        // decimates that to IQ_AND_OUTPUT_FRAMES_PER_SECOND. The receivers tune within the window.
+        class WindowDecimator
+        {
+        public:
+            WindowDecimator(unsigned inputRate, bool pcm16)
+                : m_decimate(inputRate / IQ_AND_OUTPUT_FRAMES_PER_SECOND)
+                , m_pcm16(pcm16)
+                , m_windowHz(0)
+                , m_mix(inputRate)
+                , m_mixCos(BLOCK_FRAMES)
+                , m_mixSin(BLOCK_FRAMES)
+                , m_outputsToDiscard(0)
+            {
+                reset();
+            }
+
+            unsigned get_decimate() const { return m_decimate; }
+            double get_windowHz() const { return m_windowHz; }
+
+            // The next Apply is for input frame outputFrame * get_decimate(), and the outputs of its first
+            // warmupFrames * get_decimate() frames only fill the filters. The outputs are numbered
+            // from outputFrame + warmupFrames, the same as SliceIQ would number them.
+            void Start(double windowHz, unsigned outputFrame, unsigned warmupFrames)
+            {
+                reset();
+                m_windowHz = windowHz;
+                m_mix.SetFrequency(-windowHz);
+                m_mix.SetPhase(CNco::TablePhase(windowHz));
+                m_mix.Skip(static_cast<int64_t>(outputFrame) * m_decimate);
+                m_outputsToDiscard = warmupFrames;
+            }
+
+            // Mixes and decimates numFrames input frames from p, and appends the outputs to cache.
+            void Apply(const unsigned char* p, unsigned numFrames, IqCache& cache)
+            {
+                while (numFrames > 0)
+                {
+                    const unsigned n = std::min(numFrames, static_cast<unsigned>(BLOCK_FRAMES));
+                    m_mix.Generate(&m_mixCos[0], &m_mixSin[0], n);
+                    if (m_pcm16)
+                        p = applyBlock(reinterpret_cast<const int16_t*>(p), 1.0 / 0x7FFF, n, cache);
+                    else
+                        p = applyBlock(reinterpret_cast<const float*>(p), 1.0, n, cache);
+                    numFrames -= n;
+                }
+            }
+
+        private:
+            enum { BLOCK_FRAMES = 1024 };
+
+            void reset()
+            {   // the filters start out empty
+                m_chain.reset(new CDecimationChain(m_decimate * IQ_AND_OUTPUT_FRAMES_PER_SECOND,
+                    IQ_AND_OUTPUT_FRAMES_PER_SECOND, PASSBAND_HZ, false));
+            }
+
+            template <class Sample_t>
+            const unsigned char* applyBlock(const Sample_t* q, double scale, unsigned numFrames, IqCache& cache)
+            {
+                for (unsigned i = 0; i < numFrames; i++)
+                {
+                    double inI = *q++ * scale;
+                    double inQ = *q++ * scale;
+
+                    double mixI = m_mixCos[i];
+                    double mixQ = m_mixSin[i];
+
+                    // The mix is a complex multiply
+                    double outI, outQ;
+                    if (!m_chain->applySample(inI * mixI - inQ * mixQ, inQ * mixI + inI * mixQ, outI, outQ))
+                        continue;
+                    if (m_outputsToDiscard > 0)
+                        m_outputsToDiscard -= 1;
+                    else
+                        cache.Append(static_cast<float>(outI), static_cast<float>(outQ));
+                }
+                return reinterpret_cast<const unsigned char*>(q);
+            }
+
+            static const double PASSBAND_HZ; // SliceIQ's
+
+            const unsigned m_decimate;
+            const bool m_pcm16;
+            double m_windowHz;
+            CNco m_mix;
+            std::vector<double> m_mixCos;
+            std::vector<double> m_mixSin;
+            std::unique_ptr<CDecimationChain> m_chain;
+            unsigned m_outputsToDiscard;
+        };
+        const double WindowDecimator::PASSBAND_HZ = 5250;
+
+        // Up to MAX_FRAMES_TO_PROCESS frames from the reader to the DSP...
+        struct IqBlock {
+            explicit IqBlock(unsigned maxFrames) : iq(2 * maxFrames), firstFrame(0), numFrames(0), seekNumber(0) {}
+            std::vector<float> iq; // interleaved I/Q
+            unsigned firstFrame;
+            unsigned numFrames;
+            uint32_t seekNumber; // blocks read before the most recent seek are discarded
+        };
+
+        // ...and the same frames, as audio, from the DSP to the sink.
+        struct AudioBlock {
+            explicit AudioBlock(unsigned maxFrames) : sound(maxFrames), firstFrame(0), numFrames(0), seekNumber(0) {}
+            std::vector<short> sound;
+            unsigned firstFrame;
+            unsigned numFrames;
+            uint32_t seekNumber;
+        };
+
+        // Passes blocks from one stage of the playback pipeline to the next, each stage on its own thread.
+        // The blocks are all allocated up front. m_full passes their indexes from the producer to the
+        // consumer, and m_free passes them back, so neither side ever locks.
+        template <class Block_t>
+        class StageQueue
+        {
+        public:
+            StageQueue(unsigned numBlocks, unsigned framesPerBlock)
+                : m_blocks(numBlocks, Block_t(framesPerBlock))
+                , m_full(numBlocks)
+                , m_free(numBlocks)
+                , m_pushIndex(0)
+                , m_popIndex(0)
+                , m_maxOccupancy(0)
+                , m_overruns(0)
+                , m_underruns(0)
+            {
+                for (unsigned i = 0; i < numBlocks; i++)
+                    m_free.TryPush(i);
+            }
+
+            // producer only. A block to fill, or nullptr if all of them are full.
+            Block_t* BeginPush()
+            {   return m_free.TryPop(m_pushIndex) ? &m_blocks[m_pushIndex] : nullptr;  }
+            void EndPush()
+            {
+                m_full.TryPush(m_pushIndex);
+                unsigned occupancy = static_cast<unsigned>(m_full.get_size());
+                if (occupancy > m_maxOccupancy)
+                    m_maxOccupancy = occupancy;
+            }
+            bool CanPush() const { return !m_free.empty(); }
+            void CountOverrun() { m_overruns++; } // the producer had to wait for the consumer
+
+            // consumer only. The oldest full block, or nullptr if there is none.
+            Block_t* BeginPop()
+            {   return m_full.TryPop(m_popIndex) ? &m_blocks[m_popIndex] : nullptr;  }
+            void EndPop() { m_free.TryPush(m_popIndex); }
+            bool CanPop() const { return !m_full.empty(); }
+            void CountUnderrun() { m_underruns++; } // the consumer had to wait for the producer
+
+            // any thread
+            std::string Statistics() const
+            {
+                return std::to_string(m_full.get_size()) + "/" + std::to_string(m_blocks.size()) +
+                    " blocks, maximum " + std::to_string(m_maxOccupancy) +
+                    ", overruns " + std::to_string(m_overruns) +
+                    ", underruns " + std::to_string(m_underruns);
+            }
+
+        private:
+            std::vector<Block_t> m_blocks;
+            CSpscRing<unsigned> m_full;
+            CSpscRing<unsigned> m_free;
+            unsigned m_pushIndex;
+            unsigned m_popIndex;
+            std::atomic<unsigned> m_maxOccupancy;
+            std::atomic<unsigned> m_overruns;
+            std::atomic<unsigned> m_underruns;
+        };
+
+        // What the UI thread asks of the DSP thread for a Receiver. Only the latest value of each matters, so
+        // a burst of them (as from dragging the tuning slider) costs the DSP thread just one.
+        // (Seeks go to the reader thread instead, through m_seekRequest.)
+        enum Parameter { MIX_FREQUENCY, WEAVER_FREQUENCY, BANDWIDTH, NUM_PARAMETERS };
+
+        // One mix, band pass filter and Weaver on the I/Q, playing through its own sink on its own thread.
+        // The DSP hands every block the reader reads to each Receiver.
+        struct Receiver
+        {
+            Receiver(int id, void *sink)
+                : m_id(id)
                 , m_RxFrequencyKHz(0)
                 , m_BfoOffsetKHz(0)
-                , m_stop(false)
-                , m_pause(true) // paused at the beginning
-                , m_riffReader(m_inputWave)
-                , m_bandPassFilters(2)
-                , m_MixIindex(0)
-                , m_MixQindex(0)
+                , m_bandwidth(SimpleSDR::UNINITIALIZED)
                 , m_mixFrequency(IQ_AND_OUTPUT_FRAMES_PER_SECOND) // invalid
-                , m_WeaverIindex(0)
-                , m_WeaverQindex(0)
                 , m_WeaverFreq(IQ_AND_OUTPUT_FRAMES_PER_SECOND) // invalid
-                , m_QScale(1)
-                , m_WeaverQScale(1)
+                , m_postedMask(0)
+                , m_audio(MAX_FRAMES_TO_PROCESS)
                 , m_gain(1)
                 , m_maxObserved(0)
-                , m_currentFrameNumber(0)
+                , m_audioQueue(AUDIO_BLOCKS_QUEUED, MAX_FRAMES_TO_PROCESS)
+                , m_closing(false)
             {
                 m_audioSink = std::shared_ptr<XD::AudioSink>(reinterpret_cast<XD::AudioSink*>(sink),
                     [](XD::AudioSink* p) { p->ReleaseSink(); });
+            }
+
+            const int m_id; // the first receiver is 0, and tracks the play position
+
+            // the UI thread's
+            float m_RxFrequencyKHz;
+            float m_BfoOffsetKHz;
+            SimpleSDR::SdrDecodeBandwidth m_bandwidth;
+            double m_mixFrequency; // can be negative. The last one posted
+            double m_WeaverFreq; // can be negative.
+
+            std::atomic<double> m_posted[NUM_PARAMETERS]; // valid where m_postedMask has the bit set
+            std::atomic<unsigned> m_postedMask;
+
+            // the DSP's. (Whichever of its threads has this receiver for the block at hand.)
+            SdrChain m_chain;
+            std::vector<float> m_audio;
+            double m_gain;
+            float m_maxObserved;
+
+            StageQueue<AudioBlock> m_audioQueue;
+            std::shared_ptr<XD::AudioSink> m_audioSink;
+            std::atomic<bool> m_closing; // its sink thread is to exit
+            std::thread m_sinkThread;
+        };
 
-                m_inputWave.open(fileName.c_str(), std::ifstream::binary);
-                if (!m_inputWave.is_open())
-                    throw std::runtime_error("Failed to open input file");
+        // Playback is three stages: the reader, the DSP and the sinks, passing blocks through StageQueue's.
+        // A slow disk or a sink that blocks only stalls its own thread, as long as the queues last.
+        // Each I/Q block is read and converted once, and the DSP runs it through every Receiver. With enough
+        // receivers, the DSP thread hands some of them to a pool of worker threads for each block.
+        class SimpleSDRImpl
+        {
+        public:
+            SimpleSDRImpl(const std::vector<std::string> &fileNames,
+                void *sink) // The audioSink void pointer drill accomodates passing pointers between .NET objects.
+                : m_stop(false)
+                , m_pause(true) // paused at the beginning
+                , m_riffReader(fileNames)
+                , m_readerAtEnd(false)
+                , m_sleeping(0)
+                , m_currentFrameNumber(0)
+                , m_seekRequest(0)
+                , m_readerSeekNumber(0)
+                , m_windowHz(0)
+                , m_pushFrame(0)
+                , m_commandsPosted(false)
+                , m_receiversChanged(false)
+                , m_receiversGeneration(0)
+                , m_dspReceiversGeneration(0)
+                , m_nextReceiverId(0)
+                , m_jobClaim(0)
+                , m_jobSize(0)
+                , m_jobDone(0)
+                , m_jobBlock(nullptr)
+                , m_iqQueue(IQ_BLOCKS_QUEUED, MAX_FRAMES_TO_PROCESS)
+            {
+                auto main = std::make_shared<Receiver>(m_nextReceiverId++, sink);
+
+                m_riffReader.MapFiles(); // else read through ifstreams
 
                 m_riffReader.ParseHeader();
 
                 if (m_riffReader.get_numChannels() != 2)
                     throw std::runtime_error("Input file must be stereo");
 
-                if (m_riffReader.get_format() != 3 || m_riffReader.get_bitsPerSample() != 32)
-                    throw std::runtime_error("Input file must be 32 bit float format");
+                const bool float32 = m_riffReader.get_format() == 3 && m_riffReader.get_bitsPerSample() == 32;
+                const unsigned sampleRate = m_riffReader.get_sampleRate();
+                if (sampleRate == IQ_AND_OUTPUT_FRAMES_PER_SECOND)
+                {   // from SliceIQ
+                    if (!float32)
+                        throw std::runtime_error("Input file must be 32 bit float format");
+                }
+                else
+                {   // a recording to decimate as it plays
+                    const bool pcm16 = m_riffReader.get_format() == 1 && m_riffReader.get_bitsPerSample() == 16;
+                    if (!float32 && !pcm16)
+                        throw std::runtime_error("Input file must be 32 bit float or 16 bit PCM format");
+                    const unsigned ratio = sampleRate / IQ_AND_OUTPUT_FRAMES_PER_SECOND;
+                    if (ratio < 2 || ratio * IQ_AND_OUTPUT_FRAMES_PER_SECOND != sampleRate || (ratio & (ratio - 1)) != 0)
+                        throw std::runtime_error("Input file sample rate must be 12000 times a power of two");
+                    m_front.reset(new WindowDecimator(sampleRate, pcm16));
+                    m_iqCache.reset(new IqCache(IQ_CACHE_SECONDS * IQ_AND_OUTPUT_FRAMES_PER_SECOND));
+                }
 
-                SetBandwidth(SimpleSDR::WIDE_SSB);
-                SetRxFrequencyCenterHz(0);
-                SetRxFrequencyBfoOffsetHz(0);
+                tune(*main, TuneTo(0, 0, SimpleSDR::WIDE_SSB));
+                startReceiver(main);
 
+                m_dspThread = std::thread(std::bind(&SimpleSDRImpl::dspThread, this));
                 m_thread = std::thread(std::bind(&SimpleSDRImpl::thread, this));
             }
 
@@ -90,198 +491,143 @@ namespace XDSdr {
 
             void Close()
             {
+                m_stop = true;
+                m_pause = false;
+                wake();
+                for (auto t : { &m_thread, &m_dspThread })
+                    if (t->joinable())
+                        t->join();
+                for (auto &t : m_workers) // the DSP thread started them, and is done with them
+                    t.join();
+                m_workers.clear();
+                for (auto &r : m_receivers)
                 {
-                    lock_t l(m_mutex);
-                    m_stop = true;
-                    m_pause = false;
-                    m_cond.notify_all();
+                    if (r->m_sinkThread.joinable())
+                        r->m_sinkThread.join();
+                    r->m_audioSink.reset();
                 }
-                if (m_thread.joinable())
-                    m_thread.join();
-                m_audioSink.reset();
             }
- 
+
             void Play()
             {
-                lock_t l(m_mutex);
                 m_pause = false;
-                m_cond.notify_all();
+                wake();
             }
 
             void Pause()
             {
-                lock_t l(m_mutex);
                 m_pause = true;
-                m_cond.notify_all();
+                wake();
             }
 
             float GetPlayLengthSeconds()
             {
                 auto blockAlign = m_riffReader.get_blockAlign();
                 if (blockAlign != 0)
-                    return (static_cast<float>(m_riffReader.get_dataChunkSize()) / blockAlign) / IQ_AND_OUTPUT_FRAMES_PER_SECOND;
+                    return (static_cast<float>(m_riffReader.get_dataChunkSize()) / blockAlign) / m_riffReader.get_sampleRate();
                 return 0;
             }
 
             float GetIfBoundaryAbsHz()
+            {   // the receivers tune within the I/Q the DSP gets, whatever the recording's rate
+                return IQ_AND_OUTPUT_FRAMES_PER_SECOND / 2.0f;
+            }
+
+            // A recording faster than IQ_AND_OUTPUT_FRAMES_PER_SECOND plays through a window of it that wide,
+            // which can be anywhere within GetWindowBoundaryAbsHz of the recording's center.
+            // Moving the window starts the decimation over at the play position. Tuning the receivers within
+            // the window doesn't.
+            float GetWindowBoundaryAbsHz()
             {
-                return m_riffReader.get_sampleRate() / 2.0f;
+                if (!m_front)
+                    return 0;
+                return (m_riffReader.get_sampleRate() - IQ_AND_OUTPUT_FRAMES_PER_SECOND) / 2.0f;
             }
 
-            float GetPlayPositionSeconds()
+            float GetWindowCenterHz()
+            {   return m_windowHz;  }
+
+            void SetWindowCenterHz(float v)
             {
-                lock_t l(m_mutex);
+                if (GetWindowBoundaryAbsHz() < fabs(v) || v == m_windowHz)
+                    return;
+                m_windowHz = v;
+                requestSeek(m_currentFrameNumber); // the reader sees the window moved
+            }
+
+            float GetPlayPositionSeconds()
+            {   // of the audio most recently handed to the first receiver's sink
                 return m_currentFrameNumber / static_cast<float>(IQ_AND_OUTPUT_FRAMES_PER_SECOND);
             }
 
             void SetPlayPositionSeconds(float v)
-            {
-                lock_t l(m_mutex);
-                m_queue.push_back([this, v]()
-                    {
-                        unsigned frameNumber = static_cast<unsigned>(v * IQ_AND_OUTPUT_FRAMES_PER_SECOND);
-                        m_riffReader.SeekToFrameNumber(frameNumber);
-                    });
-                m_cond.notify_all();
-            }
+            {   requestSeek(static_cast<unsigned>(v * IQ_AND_OUTPUT_FRAMES_PER_SECOND));  }
 
             float GetRxFrequencyCenterHz()
+            {   return m_receivers.front()->m_RxFrequencyKHz;  }
+
+            void SetRxFrequencyCenterHz(float v)
+            {   SetRxFrequencyCenterHz(*m_receivers.front(), v);  }
+
+            float GetRxFrequencyBfoOffsetHz()
+            {   return m_receivers.front()->m_BfoOffsetKHz;  }
+
+            void SetRxFrequencyBfoOffsetHz(float v)
+            {   SetRxFrequencyBfoOffsetHz(*m_receivers.front(), v);  }
+
+            SimpleSDR::SdrDecodeBandwidth GetBandwidth()
+            {   return m_receivers.front()->m_bandwidth;  }
+
+            void SetBandwidth(SimpleSDR::SdrDecodeBandwidth v)
+            {   SetBandwidth(*m_receivers.front(), v);  }
+
+            // The receivers after the first, which the methods above tune. A new one starts out tuned
+            // as the first one is, and hears from the block the DSP is on.
+            int AddReceiver(void *sink)
             {
-                return m_RxFrequencyKHz;
+                auto r = std::make_shared<Receiver>(m_nextReceiverId++, sink);
+                const Receiver& main = *m_receivers.front();
+                tune(*r, TuneTo(main.m_RxFrequencyKHz, main.m_BfoOffsetKHz, main.m_bandwidth));
+                startReceiver(r);
+                return r->m_id;
             }
 
-            void SetRxFrequencyCenterHz(float v)
+            // Returns once the DSP no longer has it, and its sink is released.
+            void RemoveReceiver(int id)
             {
-                if (IQ_AND_OUTPUT_FRAMES_PER_SECOND/2 <= static_cast<unsigned>(fabs(v)))
+                if (id == 0)
+                    return; // the first one plays for as long as the SDR does
+                auto it = std::find_if(m_receivers.begin(), m_receivers.end(),
+                    [id](const std::shared_ptr<Receiver>& r) { return r->m_id == id; });
+                if (it == m_receivers.end())
                     return;
-                lock_t l(m_mutex);
-                m_RxFrequencyKHz = v;
-                auto newMix = quantizeMixFrequencyTo10Hz(static_cast<int>(v), m_mixFrequency);
-                if (newMix != m_mixFrequency)
-                {
-                    m_queue.push_back([this, newMix]() 
-                    {
-                        double prevMixI = 0;
-                        double prevMixQ = 1;
-                        if (!m_MixCoef.empty())
-                        {
-                            // prep for glitch minimization
-                            // Save the phase of the previous MIX signal
-                            prevMixI = m_MixCoef[m_MixIindex];
-                            prevMixQ = m_MixCoef[m_MixQindex] * m_QScale;
-                        }
-                        // glitch minimization is an optimization in the sense
-                        // it keeps the output wave continuous when you change m_MixFreq.
-                        m_MixIindex = 0;
-                        m_MixQindex = 0;
-                        m_MixCoef.clear();
-                        m_QScale = newMix < 0 ? -1.f : 1.f;
-                        // populate the sine table.
-                        // use the same table for cosine but start in different position.
-                        bool closestOneNeg = PrecomputeSinCos::ComputeSinCos(
-                            IQ_AND_OUTPUT_FRAMES_PER_SECOND, newMix >= 0 ? newMix : -newMix, 
-                            m_MixCoef, m_MixQindex, PRECOMPUTE_SIN_COS_DENSITY);
-                        if (closestOneNeg)
-                            m_QScale *= -1.f;// flip mixQ summation if we're using upside-down cosine
-                        auto deGlitch = PrecomputeSinCos::MinimizeSinCosGlitch(prevMixI, prevMixQ, m_MixQindex, m_QScale, m_MixCoef);
-                        m_MixIindex += deGlitch; m_MixQindex += deGlitch;
-                        if (m_MixIindex >= m_MixCoef.size())
-                            m_MixIindex -= static_cast<unsigned>(m_MixCoef.size());
-                        if (m_MixQindex >= m_MixCoef.size())
-                            m_MixQindex -= static_cast<unsigned>(m_MixCoef.size());
-                        m_mixFrequency = newMix;
-                    });
-                    m_cond.notify_all();
-                }
+                std::shared_ptr<Receiver> r = *it;
+                m_receivers.erase(it);
+                const unsigned generation = publishReceivers();
+                sleepUntil([this, generation]() { return m_stop || m_dspReceiversGeneration == generation; });
+                r->m_closing = true;
+                wake();
+                if (r->m_sinkThread.joinable())
+                    r->m_sinkThread.join();
+                r->m_audioSink.reset();
             }
 
-            float GetRxFrequencyBfoOffsetHz()
+            void SetReceiverRxFrequencyCenterHz(int id, float v)
             {
-                return m_BfoOffsetKHz;
+                if (Receiver* r = findReceiver(id))
+                    SetRxFrequencyCenterHz(*r, v);
             }
 
-            void SetRxFrequencyBfoOffsetHz(float v)
+            void SetReceiverRxFrequencyBfoOffsetHz(int id, float v)
             {
-                if (IQ_AND_OUTPUT_FRAMES_PER_SECOND / 2 <= static_cast<unsigned>(fabs(v)))
-                    return;
-                lock_t l(m_mutex);
-                m_BfoOffsetKHz = v;
-                auto newMix = quantizeMixFrequencyTo10Hz(static_cast<int>(v), m_WeaverFreq);
-                if (newMix != m_WeaverFreq)
-                {
-                    m_queue.push_back([this, newMix]()
-                        {
-                            double prevMixI = 0;
-                            double prevMixQ = 1;
-                            if (!m_WeaverMix.empty())
-                            {
-                                // prep for glitch minimization
-                                // Save the phase of the previous MIX signal
-                                 prevMixI = m_WeaverMix[m_WeaverIindex];
-                                 prevMixQ = m_WeaverMix[m_WeaverQindex] * m_WeaverQScale;
-                                }
-                            // glitch minimization is an optimization in the sense
-                            // it keeps the output wave continuous when you change m_MixFreq.
-                            m_WeaverIindex = 0;
-                            m_WeaverQindex = 0;
-                            m_WeaverMix.clear();
-                            m_WeaverQScale = newMix < 0 ? -1.f : 1.f;
-                            // populate the sine table.
-                            // use the same table for cosine but start in different position.
-                            bool closestOneNeg = PrecomputeSinCos::ComputeSinCos(
-                                IQ_AND_OUTPUT_FRAMES_PER_SECOND, newMix >= 0 ? newMix : -newMix, 
-                                m_WeaverMix, m_WeaverQindex, PRECOMPUTE_SIN_COS_DENSITY);
-                            if (closestOneNeg)
-                                m_WeaverQScale *= -1.f;// flip mixQ summation if we're using upside-down cosine
-                            auto deGlitch = PrecomputeSinCos::MinimizeSinCosGlitch(prevMixI, prevMixQ, m_WeaverQindex, m_WeaverQScale, m_WeaverMix);
-                            m_WeaverIindex += deGlitch; m_WeaverQindex += deGlitch;
-                            if (m_WeaverIindex >= m_WeaverMix.size())
-                                m_WeaverIindex -= static_cast<unsigned>(m_WeaverMix.size());
-                            if (m_WeaverQindex >= m_WeaverMix.size())
-                                m_WeaverQindex -= static_cast<unsigned>(m_WeaverMix.size());
-                            m_WeaverFreq = newMix;
-                        });
-                    m_cond.notify_all();
-                }
+                if (Receiver* r = findReceiver(id))
+                    SetRxFrequencyBfoOffsetHz(*r, v);
             }
 
-            SimpleSDR::SdrDecodeBandwidth GetBandwidth()
-            {   return m_bandwidth;  }
-
-            void SetBandwidth(SimpleSDR::SdrDecodeBandwidth v)
+            void SetReceiverBandwidth(int id, SimpleSDR::SdrDecodeBandwidth v)
             {
-                lock_t l(m_mutex);
-                if (v != m_bandwidth)
-                {
-                    m_bandwidth = v;
-                    m_queue.push_back([this, v]() {
-                        unsigned len; const FilterCoeficient_t*coef;
-                        switch (v)
-                        {
-                        case SimpleSDR::NARROW_CW:
-                            len = NARROW_CW_FILTER::SAMPLEFILTER_TAP_NUM;
-                            coef = NARROW_CW_FILTER::filter_taps;
-                            break;
-                        case SimpleSDR::WIDE_CW:
-                            len = WIDE_CW_FILTER::SAMPLEFILTER_TAP_NUM;
-                            coef = WIDE_CW_FILTER::filter_taps;
-                            break;
-                        case SimpleSDR::NARROW_SSB:
-                            len = NARROW_SSB_FILTER::SAMPLEFILTER_TAP_NUM;
-                            coef = NARROW_SSB_FILTER::filter_taps;
-                            break;
-                        case SimpleSDR::WIDE_SSB:
-                            len = WIDE_SSB_FILTER::SAMPLEFILTER_TAP_NUM;
-                            coef = WIDE_SSB_FILTER::filter_taps;
-                            break;
-                        default:
-                            return;
-                        }
-                        for (auto &f : m_bandPassFilters)
-                            f.setFilterDefinition(len, coef);
-                        });
-                    m_cond.notify_all();
-                }
+                if (Receiver* r = findReceiver(id))
+                    SetBandwidth(*r, v);
             }
 
             std::string FromSliceIQ()
@@ -294,16 +640,113 @@ namespace XDSdr {
                 return ret;
             }
 
+            std::string GetPipelineStatistics()
+            {
+                std::string ret = "Reader to DSP: " + m_iqQueue.Statistics() + ". DSP to sink: " +
+                    m_receivers.front()->m_audioQueue.Statistics() + ".";
+                for (size_t i = 1; i < m_receivers.size(); i++)
+                    ret += " DSP to receiver " + std::to_string(m_receivers[i]->m_id) + ": " +
+                        m_receivers[i]->m_audioQueue.Statistics() + ".";
+                return ret;
+            }
+
         private:
             typedef std::unique_lock<std::mutex> lock_t;
+
+            struct TuneTo {
+                TuneTo(float rx, float bfo, SimpleSDR::SdrDecodeBandwidth bw) : rx(rx), bfo(bfo), bw(bw) {}
+                float rx; float bfo; SimpleSDR::SdrDecodeBandwidth bw;
+            };
+
+            void requestSeek(uint64_t frame)
+            {   // The high half of m_seekRequest counts the seeks, so every stage can tell which blocks are stale
+                uint64_t was = m_seekRequest;
+                while (!m_seekRequest.compare_exchange_weak(was, (((was >> 32) + 1) << 32) | frame))
+                    ;
+                wake();
+            }
+
+            /**************************************************************************************
+            ** the UI thread's receivers */
+            void tune(Receiver& r, const TuneTo& t)
+            {
+                SetBandwidth(r, t.bw);
+                SetRxFrequencyCenterHz(r, t.rx);
+                SetRxFrequencyBfoOffsetHz(r, t.bfo);
+            }
+
+            void startReceiver(const std::shared_ptr<Receiver>& r)
+            {
+                r->m_sinkThread = std::thread(std::bind(&SimpleSDRImpl::sinkThread, this, r.get()));
+                m_receivers.push_back(r);
+                publishReceivers();
+            }
+
+            Receiver* findReceiver(int id)
+            {
+                for (auto& r : m_receivers)
+                    if (r->m_id == id)
+                        return r.get();
+                return nullptr;
+            }
+
+            // Hands the DSP a copy of m_receivers. Returns the generation the DSP reports once it has it.
+            unsigned publishReceivers()
+            {
+                unsigned generation;
+                {
+                    lock_t l(m_mutex);
+                    m_receiversPosted = m_receivers;
+                    generation = ++m_receiversGeneration;
+                }
+                m_receiversChanged = true;
+                wake();
+                return generation;
+            }
+
+            void SetRxFrequencyCenterHz(Receiver& r, float v)
+            {
+                if (IQ_AND_OUTPUT_FRAMES_PER_SECOND/2 <= static_cast<unsigned>(fabs(v)))
+                    return;
+                r.m_RxFrequencyKHz = v;
+                if (v != r.m_mixFrequency)
+                {
+                    r.m_mixFrequency = v;
+                    post(r, MIX_FREQUENCY, v);
+                }
+            }
+
+            void SetRxFrequencyBfoOffsetHz(Receiver& r, float v)
+            {
+                if (IQ_AND_OUTPUT_FRAMES_PER_SECOND / 2 <= static_cast<unsigned>(fabs(v)))
+                    return;
+                r.m_BfoOffsetKHz = v;
+                if (v != r.m_WeaverFreq)
+                {
+                    r.m_WeaverFreq = v;
+                    post(r, WEAVER_FREQUENCY, v);
+                }
+            }
+
+            void SetBandwidth(Receiver& r, SimpleSDR::SdrDecodeBandwidth v)
+            {
+                if (v != r.m_bandwidth)
+                {
+                    r.m_bandwidth = v;
+                    post(r, BANDWIDTH, v);
+                }
+            }
+
+            /**************************************************************************************
+            ** the reader thread */
             void thread()
             {   // where the thread starts
-                RiffReader::RiffChunkFcn_t riff = [this](const char*buf, unsigned chunkSize, std::ifstream& infile)
+                RiffReader::RiffChunkFcn_t riff = [this](const char*buf, unsigned chunkSize, std::istream& infile)
                 {
                     // look for chunk that SliceIQ put in there just for us.
                     if (strncmp(buf, "0SDR", 4) == 0)
                     {
-                        std::vector<char> buf(chunkSize); 
+                        std::vector<char> buf(chunkSize);
                         infile.read(&buf[0], chunkSize);
                         lock_t l(m_mutex);
                         for (auto &c : buf)
@@ -311,186 +754,447 @@ namespace XDSdr {
                     }
                 };
                 RiffReader::AtEndFcn_t atEnd = [this]() {
-                    lock_t l(m_mutex);
-                    while (!m_stop && m_queue.empty())
-                        m_cond.wait(l);
-                    dispatchQueueItems(l);
-                    return m_stop;
+                    m_readerAtEnd = true;
+                    sleepUntil([this]() { return m_stop || seekPending(); });
+                    const bool moved = seek();
+                    m_readerAtEnd = false;
+                    if (!moved && m_front && !m_stop)
+                        decimateChunk(nullptr, 0); // replays m_iqCache, which ends where the reader is
+                    return m_stop.load();
                 };
-                m_riffReader.ProcessChunks(std::bind(&SimpleSDRImpl::chunk, this, 
-                    std::placeholders::_1, std::placeholders::_2), riff, atEnd);
+                if (m_front)
+                {
+                    startWindow(0);
+                    m_riffReader.ProcessChunks(std::bind(&SimpleSDRImpl::decimateChunk, this,
+                        std::placeholders::_1, std::placeholders::_2), riff, atEnd);
+                }
+                else
+                    m_riffReader.ProcessChunks(std::bind(&SimpleSDRImpl::chunk, this,
+                        std::placeholders::_1, std::placeholders::_2), riff, atEnd);
                 // where the thread ends
             }
 
-            typedef std::function<void()> OnChunkThreadFcn_t;
-            std::deque<OnChunkThreadFcn_t> m_queue;
+            bool seekPending() const
+            {   return static_cast<uint32_t>(m_seekRequest >> 32) != m_readerSeekNumber;  }
 
-            bool dispatchQueueItems(lock_t &l)
-            {   
-                if (!m_queue.empty())
+            // Returns false if the reader is still where it was: there was no seek to do, or m_iqCache has the frame.
+            bool seek()
+            {
+                if (!seekPending())
+                    return false;
+                uint64_t request = m_seekRequest;
+                m_readerSeekNumber = static_cast<uint32_t>(request >> 32);
+                if (!m_front)
                 {
-                    auto fcn = m_queue.front();
-                    m_queue.pop_front();
-                    l.unlock(); // don't ever call out while holding a mutex
-                    fcn();  
-                    l.lock();
+                    m_riffReader.SeekToFrameNumber(static_cast<unsigned>(request));
                     return true;
                 }
-                return false;
+                const uint64_t endFrame = m_riffReader.get_dataChunkSize() / m_riffReader.get_blockAlign() / m_front->get_decimate();
+                const unsigned frame = static_cast<unsigned>(std::min<uint64_t>(static_cast<unsigned>(request), endFrame));
+                if (m_front->get_windowHz() == m_windowHz && m_iqCache->Contains(frame))
+                {   // decimateChunk pushes from the cache up to where the reader is, and then goes on from there
+                    m_pushFrame = frame;
+                    return false;
+                }
+                startWindow(frame);
+                return true;
+            }
+
+            // Moves the reader so that m_front's first output (after its warmup) is frame, in the current window.
+            void startWindow(unsigned frame)
+            {
+                const unsigned warmup = std::min(frame, WINDOW_WARMUP_FRAMES);
+                m_front->Start(m_windowHz, frame - warmup, warmup);
+                m_riffReader.SeekToFrameNumber(static_cast<uint64_t>(frame - warmup) * m_front->get_decimate());
+                m_iqCache->Reset(frame);
+                m_pushFrame = frame;
             }
 
+            // the seek the sinks should be playing from
+            uint32_t currentSeekNumber() const
+            {   return static_cast<uint32_t>(m_seekRequest >> 32);  }
+
             bool chunk(unsigned char *p, unsigned numFrames)
             {
-                static const unsigned MAX_FRAMES_TO_PROCESS = 120; // 10 msec
+                const unsigned blockAlign = m_riffReader.get_blockAlign();
                 while (numFrames > 0)
                 {
-                    lock_t l(m_mutex);
-                    while (m_pause && m_queue.empty())
-                        m_cond.wait(l);
                     if (m_stop)
                         return false;
-                    if (dispatchQueueItems(l))
+                    if (seek())
+                        return true; // the rest of these frames are from before the seek.
+                    IqBlock* b = m_iqQueue.BeginPush();
+                    if (b == nullptr)
+                    {
+                        if (!m_pause)
+                            m_iqQueue.CountOverrun();
+                        sleepUntil([this]() { return m_stop || m_iqQueue.CanPush() || seekPending(); });
                         continue;
-                    m_currentFrameNumber = m_riffReader.CurrentFrameNumber();
-                    l.unlock();
-
-                    unsigned framesToProcess = std::min(MAX_FRAMES_TO_PROCESS, numFrames);
-                    process(reinterpret_cast<float*>(p), framesToProcess);
-                    numFrames -= framesToProcess;
-                    p += framesToProcess * m_riffReader.get_blockAlign();
+                    }
+                    // the reader is positioned after the frames we were handed
+                    b->firstFrame = static_cast<unsigned>(m_riffReader.CurrentFrameNumber() - numFrames);
+                    b->numFrames = std::min(MAX_FRAMES_TO_PROCESS, numFrames);
+                    b->seekNumber = m_readerSeekNumber;
+                    memcpy(&b->iq[0], p, b->numFrames * blockAlign);
+                    m_iqQueue.EndPush();
+                    wake();
+                    numFrames -= b->numFrames;
+                    p += b->numFrames * blockAlign;
                 }
+                return true;
+            }
 
+            // chunk, for a recording m_front decimates. Its output goes through m_iqCache on the way to the DSP.
+            bool decimateChunk(unsigned char *p, unsigned numFrames)
+            {
+                const unsigned blockAlign = m_riffReader.get_blockAlign();
+                const unsigned maxInputFrames = MAX_FRAMES_TO_PROCESS * m_front->get_decimate();
+                while (numFrames > 0 || m_pushFrame != m_iqCache->get_end())
+                {
+                    if (m_stop)
+                        return false;
+                    if (seek())
+                        return true; // the rest of these frames are from before the seek.
+                    if (m_pushFrame == m_iqCache->get_end())
+                    {   // the DSP has all of the cache, so it can take more
+                        const unsigned n = std::min(maxInputFrames, numFrames);
+                        m_front->Apply(p, n, *m_iqCache);
+                        numFrames -= n;
+                        p += n * blockAlign;
+                        continue;
+                    }
+                    IqBlock* b = m_iqQueue.BeginPush();
+                    if (b == nullptr)
+                    {
+                        if (!m_pause)
+                            m_iqQueue.CountOverrun();
+                        sleepUntil([this]() { return m_stop || m_iqQueue.CanPush() || seekPending(); });
+                        continue;
+                    }
+                    b->firstFrame = m_pushFrame;
+                    b->numFrames = m_iqCache->Read(m_pushFrame, MAX_FRAMES_TO_PROCESS, &b->iq[0]);
+                    b->seekNumber = m_readerSeekNumber;
+                    m_iqQueue.EndPush();
+                    wake();
+                    m_pushFrame += b->numFrames;
+                }
                 return true;
             }
 
-            void process(float *p, unsigned numFrames)
+            /**************************************************************************************
+            ** the DSP thread */
+            void dspThread()
             {
-                auto result = ApplyMIX(p, numFrames);
-                bool foundMax(false);
-                for (auto s : result)
+                IqBlock* in = nullptr;
+                bool flowing = false; // not counting the wait for the first block after play or seek as an underrun
+                uint32_t seekNumber = 0;
+                while (!m_stop)
                 {
-                    auto fs = fabs(s);
-                    if (fs > m_maxObserved)
+                    adoptReceivers();
+                    if (m_pause)
+                    {   // Audio processed ahead would miss any retune made while paused. (The reader goes on.)
+                        flowing = false;
+                        sleepUntil([this]() { return !m_pause || m_stop || m_receiversChanged; });
+                        continue;
+                    }
+                    dispatchCommands();
+                    if (in == nullptr && (in = m_iqQueue.BeginPop()) == nullptr)
                     {
-                        m_maxObserved = fs;
-                        foundMax = true;
+                        if (flowing && !m_readerAtEnd)
+                            m_iqQueue.CountUnderrun();
+                        flowing = false;
+                        sleepUntil([this]() { return m_stop || m_pause || m_iqQueue.CanPop() || commandsPending(); });
+                        continue;
                     }
+                    if (in->seekNumber == currentSeekNumber())
+                    {   // every receiver has to have room for it. The slowest sink sets the pace for all of them.
+                        Receiver* full = nullptr;
+                        for (auto& r : m_dspReceivers)
+                            if (!r->m_audioQueue.CanPush())
+                            {
+                                full = r.get();
+                                break;
+                            }
+                        if (full != nullptr)
+                        {
+                            full->m_audioQueue.CountOverrun();
+                            sleepUntil([this, in, full]() { return m_stop || m_pause || full->m_audioQueue.CanPush() ||
+                                commandsPending() || in->seekNumber != currentSeekNumber(); });
+                            continue;
+                        }
+                        if (seekNumber != in->seekNumber)
+                        {
+                            seekNumber = in->seekNumber;
+                            flowing = false;
+                        }
+                        processAll(*in);
+                        flowing = true;
+                    }
+                    else // it was read before the latest seek
+                        flowing = false;
+                    m_iqQueue.EndPop();
+                    in = nullptr;
+                    wake();
                 }
+            }
 
-                if (foundMax)
+            bool commandsPending() const
+            {   return m_commandsPosted || m_receiversChanged;  }
+
+            // on the DSP thread, between blocks. Takes up the latest publishReceivers
+            void adoptReceivers()
+            {
+                if (!m_receiversChanged.exchange(false))
+                    return;
                 {
-                    double peakGain = 0.5 / m_maxObserved;
-                    m_gain = sqrt(peakGain * m_gain);
+                    lock_t l(m_mutex);
+                    m_dspReceivers = m_receiversPosted;
+                    m_dspReceiversGeneration = m_receiversGeneration;
                 }
-                std::vector<short> buf(result.size());
-                for (unsigned i = 0; i < result.size(); i++)
-                    buf[i] = static_cast<short>(0x7FFF * m_gain * result[i]);
-                m_audioSink->AddMonoSoundFrames(&buf[0], numFrames);
+                const size_t maxWorkers = std::max(1u, std::thread::hardware_concurrency()) - 1;
+                const size_t workers = std::min(maxWorkers, (m_dspReceivers.size() - 1) / RECEIVERS_PER_DSP_THREAD);
+                while (m_workers.size() < workers)
+                    m_workers.emplace_back(std::bind(&SimpleSDRImpl::workerThread, this));
+                m_commandsPosted = true; // a new receiver's tuning was posted before the DSP had it
+                wake(); // RemoveReceiver waits for this
+            }
+
+            // any thread
+            void post(Receiver& r, Parameter which, double value) // Hz, or SdrDecodeBandwidth
+            {
+                r.m_posted[which].store(value, std::memory_order_relaxed);
+                r.m_postedMask.fetch_or(1u << which, std::memory_order_release); // publishes the store above
+                m_commandsPosted.store(true, std::memory_order_release);
+                wake();
             }
 
-            std::vector<float> ApplyMIX(float* p, unsigned numFrames /*I/Q frames*/)
+            // on the DSP thread. Applies whatever was posted since the last call
+            bool dispatchCommands()
             {
-                std::vector<float> ret;
-                for (int i = 0; i < static_cast<int>(numFrames); i += 1)
+                if (!m_commandsPosted.exchange(false, std::memory_order_acquire))
+                    return false;
+                for (auto& r : m_dspReceivers)
                 {
-                    float inI = *p++;
-                    float inQ = *p++;
+                    const unsigned mask = r->m_postedMask.exchange(0, std::memory_order_acquire);
+                    if (mask & (1u << MIX_FREQUENCY))
+                        r->m_chain.SetMixFrequency(r->m_posted[MIX_FREQUENCY].load(std::memory_order_relaxed));
+                    if (mask & (1u << WEAVER_FREQUENCY))
+                        r->m_chain.SetWeaverFrequency(r->m_posted[WEAVER_FREQUENCY].load(std::memory_order_relaxed));
+                    if (mask & (1u << BANDWIDTH))
+                        r->m_chain.SetBandwidth(static_cast<SimpleSDR::SdrDecodeBandwidth>(
+                            static_cast<int>(r->m_posted[BANDWIDTH].load(std::memory_order_relaxed))));
+                }
+                return true;
+            }
 
-                    unsigned sze = static_cast<unsigned>(m_MixCoef.size());
-                    double mixI = m_MixCoef[m_MixIindex];
-                    m_MixIindex += PRECOMPUTE_SIN_COS_DENSITY;
-                    if (m_MixIindex >= sze)
-                        m_MixIindex = 0;
-                    double mixQ = m_MixCoef[m_MixQindex];
-                    m_MixQindex += PRECOMPUTE_SIN_COS_DENSITY;
-                    if (m_MixQindex >= sze)
-                        m_MixQindex = 0;
-                    mixQ *= m_QScale; // flip for negative mixer frequency
+            // Runs the block through every receiver. Each has room for it in its m_audioQueue.
+            void processAll(const IqBlock& in)
+            {
+                if (m_workers.empty())
+                {
+                    for (auto& r : m_dspReceivers)
+                        process(in, *r);
+                    return;
+                }
+                // The DSP thread and the workers each claim receivers until they are all done
+                m_jobBlock = &in;
+                m_jobSize.store(static_cast<unsigned>(m_dspReceivers.size()), std::memory_order_relaxed);
+                m_jobDone.store(0, std::memory_order_relaxed);
+                const uint64_t job = (m_jobClaim.load(std::memory_order_relaxed) >> 32) + 1;
+                m_jobClaim.store(job << 32, std::memory_order_release); // publishes the job to the workers
+                wake();
+                runJob();
+                const unsigned size = static_cast<unsigned>(m_dspReceivers.size());
+                sleepUntil([this, size]() { return m_jobDone.load(std::memory_order_acquire) == size; });
+            }
 
-                    // The mix is a complex multiply
-                    double nextI = inI * mixI - inQ * mixQ;
-                    double nextQ = inQ * mixI + inI * mixQ;
-
-                    // low pass the mixed I separate from the mixed Q
-                    m_bandPassFilters[0].applySample(nextI);
-                    m_bandPassFilters[1].applySample(nextQ);
-
-                    // Now mix again. This time by the m_WeaverFreq
-                    // http://www.csun.edu/~skatz/katzpage/sdr_project/sdr/ssb_rcv_signals.pdf
-                    sze = static_cast<unsigned>(m_WeaverMix.size());
-                    double weaverI = m_WeaverMix[m_WeaverIindex];
-                    m_WeaverIindex += PRECOMPUTE_SIN_COS_DENSITY;
-                    if (m_WeaverIindex >= sze)
-                        m_WeaverIindex = 0;
-                    double weaverQ = m_WeaverMix[m_WeaverQindex];
-                    m_WeaverQindex += PRECOMPUTE_SIN_COS_DENSITY;
-                    if (m_WeaverQindex >= sze)
-                        m_WeaverQindex = 0;
+            // The DSP thread and its workers. Claims receivers from the current job until there are none left.
+            void runJob()
+            {
+                uint64_t claim = m_jobClaim.load(std::memory_order_acquire);
+                for (;;)
+                {
+                    const unsigned i = static_cast<uint32_t>(claim);
+                    if (i >= m_jobSize.load(std::memory_order_relaxed))
+                        return;
+                    // The claim succeeds only if the job is still the one read. It can't finish without this
+                    // receiver, so m_jobBlock and m_dspReceivers hold still while it is processed.
+                    if (m_jobClaim.compare_exchange_weak(claim, claim + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+                    {
+                        const unsigned size = m_jobSize.load(std::memory_order_relaxed);
+                        process(*m_jobBlock, *m_dspReceivers[i]);
+                        if (m_jobDone.fetch_add(1, std::memory_order_acq_rel) + 1 == size)
+                            wake();
+                        claim = m_jobClaim.load(std::memory_order_acquire);
+                    }
+                }
+            }
 
-                    // ...The sum of the I+Q detects Weaver
-                    double v = m_bandPassFilters[0].value() * weaverI;
-                    v += m_bandPassFilters[1].value() * weaverQ * m_WeaverQScale;
-                    ret.push_back(static_cast<float>(v));
+            void workerThread()
+            {
+                uint32_t job = 0;
+                while (!m_stop)
+                {
+                    sleepUntil([this, job]() { return m_stop || static_cast<uint32_t>(m_jobClaim >> 32) != job; });
+                    job = static_cast<uint32_t>(m_jobClaim >> 32);
+                    runJob();
                 }
-                return ret;
             }
 
-            int quantizeMixFrequencyTo10Hz(int mix, int prevMix)
+            // Everything from here through SdrChain::ApplyMIX works in buffers all sized for
+            // MAX_FRAMES_TO_PROCESS at construction, so playback makes no heap allocations.
+            void process(const IqBlock &in, Receiver &r)
             {
-                static const int RESOLUTION_HZ = 10;
-                static const int MAX_MIX = static_cast<int>(IQ_AND_OUTPUT_FRAMES_PER_SECOND / 2) - 1;
-                int mixF = mix;
-                bool isNeg = mix < 0;
-                if (isNeg)
-                    mixF = -mix;
-                mixF += RESOLUTION_HZ / 2;
-                mixF /= RESOLUTION_HZ;
-                mixF *= RESOLUTION_HZ;
-                if (mixF > MAX_MIX )
-                    mixF = MAX_MIX;
-                return isNeg ? -mixF : mixF;
+                NoAllocationScope noAllocation;
+                const unsigned numFrames = in.numFrames;
+                r.m_chain.ApplyMIX(&in.iq[0], numFrames, &r.m_audio[0]);
+                bool foundMax(false);
+                for (unsigned i = 0; i < numFrames; i++)
+                {
+                    auto fs = fabs(r.m_audio[i]);
+                    if (fs > r.m_maxObserved)
+                    {
+                        r.m_maxObserved = fs;
+                        foundMax = true;
+                    }
+                }
+
+                if (foundMax)
+                {
+                    double peakGain = 0.5 / r.m_maxObserved;
+                    r.m_gain = sqrt(peakGain * r.m_gain);
+                }
+                AudioBlock& out = *r.m_audioQueue.BeginPush();
+                for (unsigned i = 0; i < numFrames; i++)
+                    out.sound[i] = static_cast<short>(0x7FFF * r.m_gain * r.m_audio[i]);
+                out.firstFrame = in.firstFrame;
+                out.numFrames = numFrames;
+                out.seekNumber = in.seekNumber;
+                r.m_audioQueue.EndPush();
             }
 
-            std::vector<CFIRFilter> m_bandPassFilters;
-            std::vector<double> m_MixCoef;
-            unsigned m_MixIindex;
-            unsigned m_MixQindex;
-            int m_mixFrequency; // can be negative
+            /**************************************************************************************
+            ** the sink threads, one per receiver */
+            void sinkThread(Receiver* r)
+            {
+                bool flowing = false; // as in dspThread
+                uint32_t seekNumber = 0;
+                StageQueue<AudioBlock>& queue = r->m_audioQueue;
+                while (!m_stop && !r->m_closing)
+                {
+                    if (m_pause)
+                    {
+                        flowing = false;
+                        sleepUntil([this, r]() { return !m_pause || m_stop || r->m_closing; });
+                        continue;
+                    }
+                    AudioBlock* b = queue.BeginPop();
+                    if (b == nullptr)
+                    {
+                        if (flowing && !m_readerAtEnd)
+                            queue.CountUnderrun();
+                        flowing = false;
+                        sleepUntil([this, r, &queue]() { return m_stop || m_pause || r->m_closing || queue.CanPop(); });
+                        continue;
+                    }
+                    if (b->seekNumber == currentSeekNumber())
+                    {
+                        if (seekNumber != b->seekNumber)
+                        {
+                            seekNumber = b->seekNumber;
+                            flowing = false;
+                        }
+                        if (r->m_id == 0)
+                            m_currentFrameNumber = b->firstFrame;
+                        r->m_audioSink->AddMonoSoundFrames(&b->sound[0], b->numFrames);
+                        flowing = true;
+                    }
+                    else
+                        flowing = false;
+                    queue.EndPop();
+                    wake();
+                }
+            }
 
-            std::vector<double> m_WeaverMix;
-            unsigned m_WeaverIindex;
-            unsigned m_WeaverQindex;
-            int m_WeaverFreq; // can be negative
-            double m_QScale;
-            double m_WeaverQScale;
+            /**************************************************************************************
+            ** Each thread sleeps only when it can't go on: paused, at the end of the file, or
+            ** waiting on a queue. Whatever might make a sleeper's ready() true must call wake()
+            ** after. Otherwise none of the threads ever takes m_mutex. */
+            template <class Ready_t>
+            void sleepUntil(Ready_t ready)
+            {
+                if (ready())
+                    return;
+                lock_t l(m_mutex);
+                m_sleeping++;
+                std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with wake()'s
+                while (!ready())
+                    m_cond.wait(l);
+                m_sleeping--;
+            }
 
-            double m_gain;
-            float m_maxObserved;
+            void wake()
+            {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (m_sleeping != 0)
+                {   // the lock makes sure each is either still to check ready(), or waiting
+                    lock_t l(m_mutex);
+                    m_cond.notify_all();
+                }
+            }
 
-            std::ifstream m_inputWave;
             std::string m_fromSliceIQ;
-            RiffReader m_riffReader;
 
-            bool m_stop;
-            bool m_pause;
-            unsigned m_currentFrameNumber;
-            float m_RxFrequencyKHz;
-            float m_BfoOffsetKHz;
-            SimpleSDR::SdrDecodeBandwidth m_bandwidth;
-            std::shared_ptr<XD::AudioSink> m_audioSink;
+            std::atomic<bool> m_stop;
+            std::atomic<bool> m_pause;
+            RiffSequence m_riffReader; // the reader thread's. One or more files of the recording.
+            std::atomic<bool> m_readerAtEnd;
+            std::atomic<unsigned> m_sleeping; // how many threads are in sleepUntil
+            std::atomic<unsigned> m_currentFrameNumber;
+            std::atomic<uint64_t> m_seekRequest; // the number of seeks so far, in the high 32 bits, and the frame
+            uint32_t m_readerSeekNumber; // the reader thread's. the last seek it did
+            std::atomic<float> m_windowHz; // the latest SetWindowCenterHz
+            std::unique_ptr<WindowDecimator> m_front; // the reader thread's. For a recording to decimate
+            std::unique_ptr<IqCache> m_iqCache; // what m_front decimated
+            unsigned m_pushFrame; // the next frame of m_iqCache for m_iqQueue
+            std::atomic<bool> m_commandsPosted; // some receiver's m_postedMask may be set
+
+            std::vector<std::shared_ptr<Receiver>> m_receivers; // the UI thread's. The first is never removed
+            std::vector<std::shared_ptr<Receiver>> m_receiversPosted; // from publishReceivers, under m_mutex
+            std::atomic<bool> m_receiversChanged;
+            unsigned m_receiversGeneration; // under m_mutex
+            std::atomic<unsigned> m_dspReceiversGeneration; // which m_receiversPosted the DSP has
+            int m_nextReceiverId;
+
+            // the DSP thread's
+            std::vector<std::shared_ptr<Receiver>> m_dspReceivers;
+            std::vector<std::thread> m_workers;
+            std::atomic<uint64_t> m_jobClaim; // the block number, in the high 32 bits, and the next receiver to claim
+            std::atomic<unsigned> m_jobSize;
+            std::atomic<unsigned> m_jobDone;
+            const IqBlock* m_jobBlock;
+
+            StageQueue<IqBlock> m_iqQueue;
             std::condition_variable m_cond;
-            std::mutex m_mutex;
+            std::mutex m_mutex; // for m_cond, m_fromSliceIQ and m_receiversPosted
             std::thread m_thread;
+            std::thread m_dspThread;
         };
 
-        SimpleSDR::SimpleSDR(const std::string& fileName, void *sink) 
-            : m_impl(std::make_shared<SimpleSDRImpl>(fileName, sink))
+        SimpleSDR::SimpleSDR(const std::string& fileName, void *sink)
+            : m_impl(std::make_shared<SimpleSDRImpl>(std::vector<std::string>(1, fileName), sink))
+        {}
+        SimpleSDR::SimpleSDR(const std::vector<std::string>& fileNames, void *sink)
+            : m_impl(std::make_shared<SimpleSDRImpl>(fileNames, sink))
         {}
         void SimpleSDR::Close() { return m_impl->Close(); }
         void SimpleSDR::Play() { return m_impl->Play(); }
         void SimpleSDR::Pause() { return m_impl->Pause(); }
         float SimpleSDR::GetPlayLengthSeconds() { return m_impl->GetPlayLengthSeconds(); }
         float SimpleSDR::GetIfBoundaryAbsHz() { return m_impl->GetIfBoundaryAbsHz(); }
+        float SimpleSDR::GetWindowBoundaryAbsHz() { return m_impl->GetWindowBoundaryAbsHz(); }
+        float SimpleSDR::GetWindowCenterHz() { return m_impl->GetWindowCenterHz(); }
+        void SimpleSDR::SetWindowCenterHz(float v) { return m_impl->SetWindowCenterHz(v); }
         float SimpleSDR::GetPlayPositionSeconds() { return m_impl->GetPlayPositionSeconds(); }
         void SimpleSDR::SetPlayPositionSeconds(float v) { return m_impl->SetPlayPositionSeconds(v); }
         float SimpleSDR::GetRxFrequencyCenterHz() { return m_impl->GetRxFrequencyCenterHz(); }
@@ -500,462 +1204,49 @@ namespace XDSdr {
         SimpleSDR::SdrDecodeBandwidth SimpleSDR::GetBandwidth() { return m_impl->GetBandwidth(); }
         void SimpleSDR::SetBandwidth(SimpleSDR::SdrDecodeBandwidth v) { return m_impl->SetBandwidth(v); }
         std::string SimpleSDR::FromSliceIQ() { return m_impl->FromSliceIQ();}
+        std::string SimpleSDR::GetPipelineStatistics() { return m_impl->GetPipelineStatistics(); }
+        int SimpleSDR::AddReceiver(void *sink) { return m_impl->AddReceiver(sink); }
+        void SimpleSDR::RemoveReceiver(int r) { return m_impl->RemoveReceiver(r); }
+        void SimpleSDR::SetReceiverRxFrequencyCenterHz(int r, float v) { return m_impl->SetReceiverRxFrequencyCenterHz(r, v); }
+        void SimpleSDR::SetReceiverRxFrequencyBfoOffsetHz(int r, float v) { return m_impl->SetReceiverRxFrequencyBfoOffsetHz(r, v); }
+        void SimpleSDR::SetReceiverBandwidth(int r, SimpleSDR::SdrDecodeBandwidth v) { return m_impl->SetReceiverBandwidth(r, v); }
+
+        SimpleSdrDemodulator::SimpleSdrDemodulator() : m_impl(std::make_shared<SdrChain>()) {}
+        void SimpleSdrDemodulator::SetRxFrequencyCenterHz(float v) { m_impl->SetMixFrequency(v); }
+        void SimpleSdrDemodulator::SetRxFrequencyBfoOffsetHz(float v) { m_impl->SetWeaverFrequency(v); }
+        void SimpleSdrDemodulator::SetBandwidth(SimpleSDR::SdrDecodeBandwidth v) { m_impl->SetBandwidth(v); }
+        void SimpleSdrDemodulator::SkipFrames(uint64_t numFrames) { m_impl->SkipFrames(numFrames); }
+        void SimpleSdrDemodulator::Process(const float *iq, unsigned numFrames, float *audio)
+        {
+            while (numFrames > 0)
+            {
+                unsigned n = std::min(MAX_FRAMES_TO_PROCESS, numFrames);
+                m_impl->ApplyMIX(iq, n, audio);
+                iq += 2 * n;
+                audio += n;
+                numFrames -= n;
+            }
+        }
+        unsigned SimpleSdrDemodulator::get_blockFrames() { return MAX_FRAMES_TO_PROCESS; }
+        unsigned SimpleSdrDemodulator::get_historyFrames()
+        {
+            return std::max(std::max(NARROW_CW_FILTER::SAMPLEFILTER_TAP_NUM, WIDE_CW_FILTER::SAMPLEFILTER_TAP_NUM),
+                std::max(NARROW_SSB_FILTER::SAMPLEFILTER_TAP_NUM, WIDE_SSB_FILTER::SAMPLEFILTER_TAP_NUM));
+        }
+        unsigned SimpleSdrDemodulator::get_framesPerSecond() { return IQ_AND_OUTPUT_FRAMES_PER_SECOND; }
     }
 }
 
-/*************************************************************************************************
-** Filters ***************************************************************************************
-* These are all designed with octave: http://www.octave.org
-*************************************************************************************************/
-
-namespace NARROW_CW_FILTER {
-/*  Octave:
-    f = 125 / 12000
-    b = fir1(100, f)
-    freqz(b)
-    fd = fopen("d:/temp/250of6000.txt", "w")
-    fprintf(fd, "%10g,\n", b)
-    fclose(fd)
-*/
-    FilterCoeficient_t filter_taps[SAMPLEFILTER_TAP_NUM] = { 1.33275e-05,
-5.24769e-05,
-9.6034e-05,
-0.000146771,
-0.000207588,
-0.000281477,
-0.000371482,
-0.000480656,
-0.000612018,
-0.00076851,
-0.000952954,
-0.00116801,
-0.00141611,
-0.00169948,
-0.00202002,
-0.00237931,
-0.00277859,
-0.00321871,
-0.00370009,
-0.00422273,
-0.00478618,
-0.00538952,
-0.00603137,
-0.00670988,
-0.00742273,
-0.00816715,
-0.00893995,
- 0.0097375,
- 0.0105558,
- 0.0113905,
- 0.0122368,
- 0.0130899,
- 0.0139446,
- 0.0147953,
- 0.0156367,
- 0.0164631,
-  0.017269,
- 0.0180485,
- 0.0187964,
- 0.0195071,
- 0.0201755,
- 0.0207966,
- 0.0213659,
- 0.0218789,
- 0.0223318,
- 0.0227212,
- 0.0230439,
- 0.0232976,
- 0.0234803,
- 0.0235904,
- 0.0236272,
- 0.0235904,
- 0.0234803,
- 0.0232976,
- 0.0230439,
- 0.0227212,
- 0.0223318,
- 0.0218789,
- 0.0213659,
- 0.0207966,
- 0.0201755,
- 0.0195071,
- 0.0187964,
- 0.0180485,
-  0.017269,
- 0.0164631,
- 0.0156367,
- 0.0147953,
- 0.0139446,
- 0.0130899,
- 0.0122368,
- 0.0113905,
- 0.0105558,
- 0.0097375,
-0.00893995,
-0.00816715,
-0.00742273,
-0.00670988,
-0.00603137,
-0.00538952,
-0.00478618,
-0.00422273,
-0.00370009,
-0.00321871,
-0.00277859,
-0.00237931,
-0.00202002,
-0.00169948,
-0.00141611,
-0.00116801,
-0.000952954,
-0.00076851,
-0.000612018,
-0.000480656,
-0.000371482,
-0.000281477,
-0.000207588,
-0.000146771,
-9.6034e-05,
-5.24769e-05,
-1.33275e-05,
-    };
-}
-namespace WIDE_CW_FILTER {
-    /*  Octave:
-        f = 250/12000
-        b = fir1(100,f)
-        freqz(b)
-        fd=fopen("d:/temp/CW500.txt", "w")
-        fprintf(fd, "%10g,\n", b)
-        fclose(fd)    
-        */
-    FilterCoeficient_t filter_taps[SAMPLEFILTER_TAP_NUM] ={
-1.33275e-05,
-5.24769e-05,
-9.6034e-05,
-0.000146771,
-0.000207588,
-0.000281477,
-0.000371482,
-0.000480656,
-0.000612018,
-0.00076851,
-0.000952954,
-0.00116801,
-0.00141611,
-0.00169948,
-0.00202002,
-0.00237931,
-0.00277859,
-0.00321871,
-0.00370009,
-0.00422273,
-0.00478618,
-0.00538952,
-0.00603137,
-0.00670988,
-0.00742273,
-0.00816715,
-0.00893995,
- 0.0097375,
- 0.0105558,
- 0.0113905,
- 0.0122368,
- 0.0130899,
- 0.0139446,
- 0.0147953,
- 0.0156367,
- 0.0164631,
-  0.017269,
- 0.0180485,
- 0.0187964,
- 0.0195071,
- 0.0201755,
- 0.0207966,
- 0.0213659,
- 0.0218789,
- 0.0223318,
- 0.0227212,
- 0.0230439,
- 0.0232976,
- 0.0234803,
- 0.0235904,
- 0.0236272,
- 0.0235904,
- 0.0234803,
- 0.0232976,
- 0.0230439,
- 0.0227212,
- 0.0223318,
- 0.0218789,
- 0.0213659,
- 0.0207966,
- 0.0201755,
- 0.0195071,
- 0.0187964,
- 0.0180485,
-  0.017269,
- 0.0164631,
- 0.0156367,
- 0.0147953,
- 0.0139446,
- 0.0130899,
- 0.0122368,
- 0.0113905,
- 0.0105558,
- 0.0097375,
-0.00893995,
-0.00816715,
-0.00742273,
-0.00670988,
-0.00603137,
-0.00538952,
-0.00478618,
-0.00422273,
-0.00370009,
-0.00321871,
-0.00277859,
-0.00237931,
-0.00202002,
-0.00169948,
-0.00141611,
-0.00116801,
-0.000952954,
-0.00076851,
-0.000612018,
-0.000480656,
-0.000371482,
-0.000281477,
-0.000207588,
-0.000146771,
-9.6034e-05,
-5.24769e-05,
-1.33275e-05,
-    };
-}
-namespace NARROW_SSB_FILTER {
-    /*  Octave:
-        f = 1020/12000
-        b = fir1(100,f)
-        fd=fopen("d:/temp/SSB2040.txt", "w")
-        fprintf(fd, "%10g,\n", b)
-        fclose(fd)
-        */
-    FilterCoeficient_t filter_taps[SAMPLEFILTER_TAP_NUM] = 
-    {
-0.000299054,
-0.000188022,
-5.73147e-05,
--9.45361e-05,
--0.000267475,
--0.000458224,
--0.000658816,
--0.000855647,
--0.00102931,
--0.0011554,
--0.00120632,
--0.00115407,
--0.000973822,
--0.00064789,
--0.000169779,
-0.000452272,
-0.00119269,
-0.00200744,
-0.00283464,
-0.00359726,
-0.00420787,
- 0.0045753,
-0.00461276,
-0.00424705,
-0.00342781,
-0.00213626,
-0.000392428,
--0.00173999,
--0.00415175,
--0.00668977,
--0.00916253,
--0.0113493,
--0.0130124,
--0.0139128,
--0.0138265,
- -0.012562,
--0.00997698,
--0.00599262,
--0.000604795,
-0.00610914,
- 0.0139888,
- 0.0227944,
- 0.0322168,
- 0.0418914,
- 0.0514174,
- 0.0603798,
- 0.0683734,
- 0.0750261,
-  0.080022,
- 0.0831202,
- 0.0841701,
- 0.0831202,
-  0.080022,
- 0.0750261,
- 0.0683734,
- 0.0603798,
- 0.0514174,
- 0.0418914,
- 0.0322168,
- 0.0227944,
- 0.0139888,
-0.00610914,
--0.000604795,
--0.00599262,
--0.00997698,
- -0.012562,
--0.0138265,
--0.0139128,
--0.0130124,
--0.0113493,
--0.00916253,
--0.00668977,
--0.00415175,
--0.00173999,
-0.000392428,
-0.00213626,
-0.00342781,
-0.00424705,
-0.00461276,
- 0.0045753,
-0.00420787,
-0.00359726,
-0.00283464,
-0.00200744,
-0.00119269,
-0.000452272,
--0.000169779,
--0.00064789,
--0.000973822,
--0.00115407,
--0.00120632,
--0.0011554,
--0.00102931,
--0.000855647,
--0.000658816,
--0.000458224,
--0.000267475,
--9.45361e-05,
-5.73147e-05,
-0.000188022,
-0.000299054,
-    };
-}
-namespace WIDE_SSB_FILTER {
-    /*  Octave:
-        f = 1200/12000
-        b = fir1(100,f)
-        freqz(b)
-        fd = fopen("d:/temp/2400of6000.txt", "w")
-        fprintf(fd, "%10g,\n", b)
-        fclose(fd)
-    */
-    FilterCoeficient_t filter_taps[SAMPLEFILTER_TAP_NUM] = { 
--7.74788e-05,
--0.000367152,
--0.00054399,
--0.000532634,
--0.000304421,
-9.94694e-05,
-0.000559382,
-0.000897583,
-0.00093385,
-0.000564832,
--0.00016314,
--0.00102717,
--0.00167654,
--0.00175765,
--0.00107753,
-0.000262436,
-0.00183457,
-0.00299675,
-0.00313153,
-0.00193186,
--0.000387748,
--0.00306799,
--0.00502119,
--0.00524086,
--0.00326123,
-0.000526855,
-0.00487117,
-0.00802679,
-0.00840902,
-0.00530257,
--0.00066613,
--0.00753681,
--0.0125862,
--0.0133231,
--0.00857107,
-0.000791895,
- 0.0117942,
- 0.0201706,
- 0.0218272,
-  0.014515,
--0.000891776,
--0.0200518,
-  -0.03601,
--0.0411124,
--0.0294477,
-0.000955936,
- 0.0469428,
-  0.100533,
-   0.15074,
-  0.186421,
-  0.199326,
-  0.186421,
-   0.15074,
-  0.100533,
- 0.0469428,
-0.000955936,
--0.0294477,
--0.0411124,
-  -0.03601,
--0.0200518,
--0.000891776,
-  0.014515,
- 0.0218272,
- 0.0201706,
- 0.0117942,
-0.000791895,
--0.00857107,
--0.0133231,
--0.0125862,
--0.00753681,
--0.00066613,
-0.00530257,
-0.00840902,
-0.00802679,
-0.00487117,
-0.000526855,
--0.00326123,
--0.00524086,
--0.00502119,
--0.00306799,
--0.000387748,
-0.00193186,
-0.00313153,
-0.00299675,
-0.00183457,
-0.000262436,
--0.00107753,
--0.00175765,
--0.00167654,
--0.00102717,
--0.00016314,
-0.000564832,
-0.00093385,
-0.000897583,
-0.000559382,
-9.94694e-05,
--0.000304421,
--0.000532634,
--0.00054399,
--0.000367152,
--7.74788e-05,
-    };
+#if defined(SIMPLESDR_ASSERT_NO_ALLOC)
+// Replaces the global operator new (the array and nothrow forms all call this one)
+// so that allocating inside a NoAllocationScope asserts.
+void* operator new(std::size_t size)
+{
+    assert(!XDSdr::impl::t_assertNoAllocation);
+    if (void* p = std::malloc(size != 0 ? size : 1))
+        return p;
+    throw std::bad_alloc();
 }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#endif
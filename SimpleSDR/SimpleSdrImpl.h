@@ -1,20 +1,30 @@
 /* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
 #pragma once
 #include <string>
+#include <vector>
 #include <memory>
+#include <cstdint>
 namespace XDSdr {
     namespace impl {
         class SimpleSDRImpl;
+        class SdrChain;
         
         class SimpleSDR {
         public:
             enum SdrDecodeBandwidth { NARROW_CW, WIDE_CW, NARROW_SSB, WIDE_SSB, UNINITIALIZED};
             SimpleSDR(const std::string &fileName, void *);
+            // A recording split across several files, played as one. They're put in the order of their start times.
+            SimpleSDR(const std::vector<std::string> &fileNames, void *);
             void Close();
             void Play();
             void Pause();
             float GetPlayLengthSeconds();
             float GetIfBoundaryAbsHz();
+            // A recording at more than 12000 frames per second is decimated as it plays, in a window that
+            // wide. Its center is relative to the recording's, and can be up to GetWindowBoundaryAbsHz from it.
+            float GetWindowBoundaryAbsHz(); // 0 for a recording at 12000
+            float GetWindowCenterHz();
+            void SetWindowCenterHz(float);
             float GetPlayPositionSeconds();
             void SetPlayPositionSeconds(float);
             float GetRxFrequencyCenterHz();
@@ -22,11 +32,40 @@ namespace XDSdr {
             float GetRxFrequencyBfoOffsetHz();
             void SetRxFrequencyBfoOffsetHz(float);
             std::string FromSliceIQ();
+            std::string GetPipelineStatistics(); // how full each playback queue is, and how often each stage waited
             SdrDecodeBandwidth GetBandwidth();
             void SetBandwidth(SdrDecodeBandwidth);
+
+            // More receivers of the same I/Q, each playing to its own sink. The methods above tune receiver
+            // 0, the one constructed with the sink, which can't be removed. The I/Q is read once for all of them.
+            int AddReceiver(void *sink); // returns the receiver's id, tuned to where receiver 0 is
+            void RemoveReceiver(int);
+            void SetReceiverRxFrequencyCenterHz(int, float);
+            void SetReceiverRxFrequencyBfoOffsetHz(int, float);
+            void SetReceiverBandwidth(int, SdrDecodeBandwidth);
         protected:
             std::shared_ptr<SimpleSDRImpl> m_impl;
         };
+
+        // The mix, band pass filters and Weaver mix that SimpleSDR plays through, for demodulating
+        // I/Q at get_framesPerSecond() into audio without playing it.
+        class SimpleSdrDemodulator {
+        public:
+            SimpleSdrDemodulator();
+            void SetRxFrequencyCenterHz(float);
+            void SetRxFrequencyBfoOffsetHz(float);
+            void SetBandwidth(SimpleSDR::SdrDecodeBandwidth);
+            // Advance the oscillators as if numFrames had been processed.
+            void SkipFrames(uint64_t numFrames);
+            // iq is numFrames interleaved I/Q pairs, and audio gets numFrames. They are processed in blocks
+            // of get_blockFrames(). Demodulators handed the same frames in the same blocks give the same audio.
+            void Process(const float *iq, unsigned numFrames, float *audio);
+            static unsigned get_blockFrames();
+            static unsigned get_historyFrames(); // the most frames the filters remember
+            static unsigned get_framesPerSecond();
+        protected:
+            std::shared_ptr<SdrChain> m_impl;
+        };
     }
 }
 
@@ -0,0 +1,415 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#include "FilterOctave.h"
+
+namespace Filter_Octave {
+    /*  f = 10500 / 192000
+        b = fir1(400, f)
+        fd = fopen("d:/temp/10500.txt", "w")
+        fprintf(fd, "%10g,\n", b)
+        fclose(fd)    
+    */
+    FilterCoeficient_t filter_taps[SAMPLEFILTER_TAP_NUM] =
+    {
+9.81549e-05,
+0.000113028,
+0.000125003,
+0.000133747,
+0.000138991,
+0.000140533,
+0.000138247,
+0.000132085,
+0.000122087,
+0.000108378,
+9.11761e-05,
+7.07902e-05,
+4.76195e-05,
+2.21512e-05,
+-5.0452e-06,
+-3.33251e-05,
+-6.19794e-05,
+-9.02473e-05,
+-0.000117332,
+-0.000142418,
+-0.000164694,
+-0.000183369,
+-0.000197705,
+-0.000207032,
+-0.000210779,
+-0.000208495,
+-0.000199871,
+-0.000184762,
+-0.000163201,
+-0.000135412,
+-0.000101821,
+-6.3053e-05,
+-1.99308e-05,
+2.65357e-05,
+7.51676e-05,
+0.00012464,
+0.000173515,
+0.000220272,
+0.000263358,
+0.000301225,
+0.000332383,
+0.00035545,
+0.000369202,
+0.000372621,
+0.000364943,
+0.000345696,
+0.000314735,
+0.000272269,
+0.000218875,
+0.000155506,
+8.34812e-05,
+4.4726e-06,
+-7.95297e-05,
+-0.000166258,
+-0.000253224,
+-0.000337777,
+-0.000417186,
+-0.000488713,
+-0.000549702,
+-0.000597669,
+-0.000630382,
+-0.000645954,
+-0.000642917,
+-0.000620295,
+-0.000577656,
+-0.000515165,
+-0.000433605,
+-0.00033439,
+-0.000219556,
+-9.17314e-05,
+4.59135e-05,
+0.000189734,
+0.000335699,
+0.000479496,
+0.000616647,
+0.000742642,
+0.000853072,
+0.000943775,
+0.00101097,
+0.00105141,
+0.00106247,
+0.00104232,
+0.000989951,
+0.00090531,
+0.000789308,
+0.000643857,
+0.000471856,
+0.000277154,
+6.44747e-05,
+-0.000160681,
+-0.000392166,
+-0.000623345,
+-0.000847271,
+-0.00105688,
+-0.0012452,
+-0.00140558,
+-0.00153186,
+-0.00161866,
+-0.0016615,
+-0.00165701,
+-0.0016031,
+-0.00149905,
+-0.00134562,
+-0.00114506,
+-0.000901154,
+-0.000619154,
+-0.000305683,
+3.13903e-05,
+0.000383135,
+0.000739776,
+0.00109095,
+0.00142598,
+0.00173418,
+ 0.0020052,
+0.00222931,
+0.00239773,
+0.00250293,
+0.00253893,
+0.00250151,
+0.00238844,
+0.00219962,
+0.00193719,
+0.00160553,
+0.00121129,
+0.000763231,
+0.000272113,
+-0.000249564,
+-0.000787838,
+-0.00132763,
+-0.00185312,
+-0.00234822,
+-0.00279696,
+-0.00318403,
+-0.00349518,
+-0.00371776,
+-0.0038411,
+-0.00385691,
+-0.00375964,
+-0.0035468,
+-0.00321907,
+-0.00278054,
+-0.00223866,
+-0.00160425,
+-0.000891279,
+-0.000116672,
+0.00070006,
+0.00153725,
+0.00237156,
+0.00317861,
+0.00393353,
+0.00461173,
+0.00518951,
+0.00564479,
+0.00595784,
+0.00611187,
+0.00609368,
+0.00589418,
+0.00550887,
+0.00493815,
+0.00418761,
+0.00326811,
+0.00219578,
+0.000991891,
+-0.000317443,
+-0.00170168,
+-0.0031264,
+-0.00455392,
+-0.00594414,
+-0.00725529,
+-0.00844495,
+-0.00947096,
+-0.0102925,
+-0.0108709,
+-0.0111709,
+-0.0111614,
+-0.0108164,
+-0.0101158,
+-0.00904593,
+-0.00760025,
+-0.00577968,
+-0.00359284,
+-0.00105609,
+0.00180654,
+0.00496366,
+0.00837698,
+ 0.0120019,
+ 0.0157883,
+ 0.0196813,
+ 0.0236227,
+ 0.0275515,
+ 0.0314056,
+ 0.0351226,
+ 0.0386417,
+  0.041904,
+ 0.0448545,
+ 0.0474431,
+ 0.0496252,
+  0.051363,
+ 0.0526265,
+ 0.0533936,
+ 0.0536507,
+ 0.0533936,
+ 0.0526265,
+  0.051363,
+ 0.0496252,
+ 0.0474431,
+ 0.0448545,
+  0.041904,
+ 0.0386417,
+ 0.0351226,
+ 0.0314056,
+ 0.0275515,
+ 0.0236227,
+ 0.0196813,
+ 0.0157883,
+ 0.0120019,
+0.00837698,
+0.00496366,
+0.00180654,
+-0.00105609,
+-0.00359284,
+-0.00577968,
+-0.00760025,
+-0.00904593,
+-0.0101158,
+-0.0108164,
+-0.0111614,
+-0.0111709,
+-0.0108709,
+-0.0102925,
+-0.00947096,
+-0.00844495,
+-0.00725529,
+-0.00594414,
+-0.00455392,
+-0.0031264,
+-0.00170168,
+-0.000317443,
+0.000991891,
+0.00219578,
+0.00326811,
+0.00418761,
+0.00493815,
+0.00550887,
+0.00589418,
+0.00609368,
+0.00611187,
+0.00595784,
+0.00564479,
+0.00518951,
+0.00461173,
+0.00393353,
+0.00317861,
+0.00237156,
+0.00153725,
+0.00070006,
+-0.000116672,
+-0.000891279,
+-0.00160425,
+-0.00223866,
+-0.00278054,
+-0.00321907,
+-0.0035468,
+-0.00375964,
+-0.00385691,
+-0.0038411,
+-0.00371776,
+-0.00349518,
+-0.00318403,
+-0.00279696,
+-0.00234822,
+-0.00185312,
+-0.00132763,
+-0.000787838,
+-0.000249564,
+0.000272113,
+0.000763231,
+0.00121129,
+0.00160553,
+0.00193719,
+0.00219962,
+0.00238844,
+0.00250151,
+0.00253893,
+0.00250293,
+0.00239773,
+0.00222931,
+ 0.0020052,
+0.00173418,
+0.00142598,
+0.00109095,
+0.000739776,
+0.000383135,
+3.13903e-05,
+-0.000305683,
+-0.000619154,
+-0.000901154,
+-0.00114506,
+-0.00134562,
+-0.00149905,
+-0.0016031,
+-0.00165701,
+-0.0016615,
+-0.00161866,
+-0.00153186,
+-0.00140558,
+-0.0012452,
+-0.00105688,
+-0.000847271,
+-0.000623345,
+-0.000392166,
+-0.000160681,
+6.44747e-05,
+0.000277154,
+0.000471856,
+0.000643857,
+0.000789308,
+0.00090531,
+0.000989951,
+0.00104232,
+0.00106247,
+0.00105141,
+0.00101097,
+0.000943775,
+0.000853072,
+0.000742642,
+0.000616647,
+0.000479496,
+0.000335699,
+0.000189734,
+4.59135e-05,
+-9.17314e-05,
+-0.000219556,
+-0.00033439,
+-0.000433605,
+-0.000515165,
+-0.000577656,
+-0.000620295,
+-0.000642917,
+-0.000645954,
+-0.000630382,
+-0.000597669,
+-0.000549702,
+-0.000488713,
+-0.000417186,
+-0.000337777,
+-0.000253224,
+-0.000166258,
+-7.95297e-05,
+4.4726e-06,
+8.34812e-05,
+0.000155506,
+0.000218875,
+0.000272269,
+0.000314735,
+0.000345696,
+0.000364943,
+0.000372621,
+0.000369202,
+0.00035545,
+0.000332383,
+0.000301225,
+0.000263358,
+0.000220272,
+0.000173515,
+0.00012464,
+7.51676e-05,
+2.65357e-05,
+-1.99308e-05,
+-6.3053e-05,
+-0.000101821,
+-0.000135412,
+-0.000163201,
+-0.000184762,
+-0.000199871,
+-0.000208495,
+-0.000210779,
+-0.000207032,
+-0.000197705,
+-0.000183369,
+-0.000164694,
+-0.000142418,
+-0.000117332,
+-9.02473e-05,
+-6.19794e-05,
+-3.33251e-05,
+-5.0452e-06,
+2.21512e-05,
+4.76195e-05,
+7.07902e-05,
+9.11761e-05,
+0.000108378,
+0.000122087,
+0.000132085,
+0.000138247,
+0.000140533,
+0.000138991,
+0.000133747,
+0.000125003,
+0.000113028,
+9.81549e-05,
+    };
+}
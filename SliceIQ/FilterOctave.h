@@ -0,0 +1,10 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+#pragma once
+#include <FIRFilter.h>
+
+// SliceIQ's low pass from 192KHz to 12KHz.
+namespace Filter_Octave {
+    const int SAMPLEFILTER_TAP_NUM(401);
+    extern FilterCoeficient_t filter_taps[];
+    const double PASSBAND_HZ = 5250; // the cutoff those taps were designed with
+}
@@ -5,11 +5,18 @@
 ** and outputs a 12KHz rate stereo file as output.
 **
 ** SliceIQ <InputFile.wav> <OutputFile.wav>
+**      Either can be - for standard input or output, so SliceIQ can sit in a pipeline. Standard input is read
+**      only in order, as it comes. Standard output's header has the sizes for outputIntervalSeconds if that
+**      is given (or the input's, if it says), and otherwise the all-ones sizes that mean "to the end of the stream."
 **
 ** The input is described by these optional command line arguments:
 ** --inputCenterKHz=nnnnn
 ** --inputIsFlipped   The I channel, by definition, is ahead of Q by 90 degrees, but this flips it.
 ** --inputStartTime=YYYY/MM/DD-HH:MM:SS
+** --inputFile=<NextFile.wav>
+**      Another file of the same recording, for a recorder that starts a new file every so often. May be
+**      repeated. The files are put in the order of the start times recorded in them (else taken in the order
+**      given) and read as one continuous input. inputStartTime is the start of the first.
 **
 ** The output subset is defined by these command line arguments
 ** --outputCenterKHz=nnnnn
@@ -17,10 +24,49 @@
 ** --outputStartOffsetSeconds=nnnnn
 ** --outputStartTime=YYYY/MM/DD-HH:MM:SS
 **      Those last two are redundant with each other. If both are specified, outputStartOffsetSeconds is used
+**
+** The processing is selected by these optional command line arguments
+** --decimator=fir|halfband|cic|bandpass
+**      fir is a single stage 401 tap filter, and is the default.
+**      halfband is a cascade of 4 decimate-by-2 stages (192K, 96K, 48K, 24K to 12K) that needs a fraction of the multiplies.
+**      cic replaces the first two halfband stages with a CIC decimate-by-4.
+**      halfband and cic are fed as much further ahead in the input as their filters delay it more than fir's does,
+**      so all the decimators' outputs line up in time.
+**      bandpass shifts the 401 tap filter to the output frequency and mixes at the 12K output rate instead of the 192K input.
+** --channelize
+**      Split the entire 192KHz input into all 16 of its 12KHz wide channels in one pass. outputCenterKHz is ignored
+**      and OutputFile.wav is instead the pattern for the 16 output file names: OutputFile_<centerKHz>.wav
+** --outputFormat=wav|rf64|w64
+**      wav (the default) is a RIFF file, unless the output is too big for RIFF's 32 bit sizes, in which case it is RF64.
+**      rf64 is the EBU's 64 bit extension of RIFF, and w64 is Sony Wave64. The input can be any of the three.
+**
+** SliceIQ <InputFile.wav> --manifest=<Manifest.txt>
+**      Each line of the manifest is a slice job: an output file name followed by any of the output
+**      subset and processing arguments above. (Blank lines, and lines starting with #, are ignored.)
+**      All the jobs are processed in one sequential read of the input.
+**
+** --threads=N
+**      Split each output into N segments of the input and process them at the same time on N threads.
+**      Each thread first runs the filters over a few thousand input frames ahead of its segment
+**      and discards those outputs, so the output file is identical to the single thread one.
+**      Cannot be combined with --channelize.
+**
+** --inputReader=map|readahead|stream
+**      map (the default) reads the input through a memory mapping, or through readahead if it can't be mapped.
+**      readahead reads it on a background thread, several megabytes ahead of the processing, and
+**      reports how often each side waited for the other.
+**      stream reads it 800 bytes at a time on the processing thread.
+**
+** --follow[=idleSeconds]
+**      For an input the recorder is still writing (its 'data' size is zero, or past the end of the file).
+**      At the end of the input, wait for the recorder to write more and process that, until it has written
+**      nothing for idleSeconds (default 30). The output is written as it goes, and its header's sizes are
+**      left at zero until the end, as a recorder's would be. Cannot be combined with --threads.
 */
 #include <string>
 #include <cstring>
 #include <cmath>
+#include <complex>
 #include <memory>
 #include <vector>
 #include <iostream>
@@ -29,10 +75,16 @@
 #include <chrono>
 #include <iomanip>
 #include <algorithm>
+#include <functional>
+#include <thread>
 
-#include <PrecomputeSinCos.h>
+#include <Nco.h>
 #include <FIRFilter.h>
-#include <RiffReader.h>
+#include <HalfbandDecimator.h>
+#include <RiffSequence.h>
+#include <AsyncWriter.h>
+#include <FileWatcher.h>
+#include "FilterOctave.h"
 
 namespace {
     const char InputCenterArg[] = "--inputCenterKHz=";
@@ -42,66 +94,100 @@ namespace {
     const char OutputStartSecondsArg[] = "--outputStartOffsetSeconds=";
     const char OutputStartTimeArg[] = "--outputStartTime=";
     const char OutputIntervalSecondsArg[] = "--outputIntervalSeconds=";
+    const char DecimatorArg[] = "--decimator=";
+    const char ChannelizeArg[] = "--channelize";
+    const char ManifestArg[] = "--manifest=";
+    const char ThreadsArg[] = "--threads=";
+    const char InputReaderArg[] = "--inputReader=";
+    const char InputFileArg[] = "--inputFile=";
+    const char OutputFormatArg[] = "--outputFormat=";
+    const char FollowArg[] = "--follow";
+    const char StandardStreamName[] = "-"; // as the input or output file name
 
     const int INPUT_IQ_SAMPLES_PER_SECOND = 192000;
     const int OUTPUT_IQ_SAMPLES_PER_SECOND = 12000;
     const int DECIMATE = INPUT_IQ_SAMPLES_PER_SECOND / OUTPUT_IQ_SAMPLES_PER_SECOND;
     const char DateFormatDescriptor[] = "%Y/%m/%d-%H:%M:%S";
+    const unsigned FOLLOW_IDLE_SECONDS = 30;
+    const unsigned FOLLOW_POLL_MSEC = 1000; // in case the file watcher misses a write
+
+    enum class DecimatorType { FIR, HALFBAND, CIC, BANDPASS };
+    enum class InputReaderType { MAP, READ_AHEAD, STREAM };
 
     const int usage()
     {
-        std::cerr << "Usage: SliceIQ [inputFile.wav] [outputFile.wav] " << InputCenterArg << "f  " << InputIsFlippedArg  << "  " << 
-            InputStartArg << "YYYY/MM/DD-HH:MM:SS\\" << std::endl
+        std::cerr << "Usage: SliceIQ [inputFile.wav|-] [outputFile.wav|-] " << InputCenterArg << "f  " << InputIsFlippedArg  << "  " << 
+            InputStartArg << "YYYY/MM/DD-HH:MM:SS [" << InputFileArg << "NextFile.wav ...]\\" << std::endl
             << " " << OutputCenterKHzArg << "f  [" << OutputStartSecondsArg << "s " << OutputStartTimeArg << "YYYY/MM/DD-HH:MM:SS] " << OutputIntervalSecondsArg << "s"
+            << std::endl
+            << " [" << DecimatorArg << "fir|halfband|cic|bandpass] [" << ChannelizeArg << "] [" << OutputFormatArg << "wav|rf64|w64]"
+            << std::endl
+            << "Usage: SliceIQ [inputFile.wav] " << ManifestArg << "manifest.txt ..."
+            << std::endl
+            << " [" << ThreadsArg << "n] [" << InputReaderArg << "map|readahead|stream] [" << FollowArg << "[=idleSeconds]]"
             << std::endl;
         return 1;
     }
 
-    int process(std::ifstream& inputFile, double inputCenterKHz, std::chrono::system_clock::time_point inputStartTime,
-        unsigned inputFramesToSkip, unsigned inputFramesToProcess, std::ofstream& outputFile, double outputCenterKHz,
-        std::chrono::system_clock::time_point outputStartTime);
+    // One output of a run. From the command line, or from a line of the manifest.
+    struct SliceJob {
+        SliceJob()
+            : outputInterval(std::chrono::seconds(0))
+            , outputStartOffset(std::chrono::seconds(0))
+            , outputStartTimeSpecified(false)
+            , outputCenterKHz(0)
+            , decimatorType(DecimatorType::FIR)
+            , channelize(false)
+            , outputContainer(RiffReader::RIFF)
+            , inputFramesToSkip(0)
+            , inputFramesToProcess(0)
+        {}
+        std::string outputFileName;
+        std::chrono::system_clock::duration outputInterval;
+        std::chrono::system_clock::duration outputStartOffset;
+        std::chrono::system_clock::time_point outputStartTime;
+        bool outputStartTimeSpecified;
+        double outputCenterKHz;
+        DecimatorType decimatorType;
+        bool channelize;
+        RiffReader::Container outputContainer; // RIFF becomes RF64 if it has to
+        // set by resolveJob
+        uint64_t inputFramesToSkip;
+        uint64_t inputFramesToProcess;
+    };
+
+    int parseOutputArg(const std::string& arg, SliceJob& job);
+    bool resolveJob(SliceJob& job, double inputCenterKHz, std::chrono::system_clock::time_point inputStartTime);
+    bool readManifest(const std::string& manifestFileName, std::vector<SliceJob>& jobs);
+
+    int process(const std::vector<std::string>& inputFileNames, double inputCenterKHz, 
+        std::vector<SliceJob>& jobs, unsigned threads, InputReaderType inputReader, unsigned followSeconds);
 }
 
 
 int main(int argc, char **argv)
 {
-    std::ifstream inputFile;
-    std::ofstream outputFile;
+    std::string inputFileName;
+    std::vector<std::string> inputFileNames; // after inputFileName
     bool inputIQflipped = false;
     std::chrono::system_clock::time_point inputStartTime = std::chrono::system_clock::now();
     double inputCenterKHz = 0;
+    SliceJob job;
+    std::string manifestFileName;
+    unsigned threads = 1;
+    InputReaderType inputReader = InputReaderType::MAP;
+    unsigned followSeconds = 0; // zero is not following
 
-    std::chrono::system_clock::duration outputInterval = std::chrono::seconds(0);
-    std::chrono::system_clock::duration outputStartOffset = std::chrono::seconds(0);
-    std::chrono::system_clock::time_point outputStartTime = inputStartTime;
-    bool outputStartTimeSpecified = false;
-    double outputCenterKHz = 0;
-
-    
     // parse command line arguments
     for (int i = 1; i < argc; i++)
     {
         std::string arg = argv[i];
         if (arg.find("--") != 0)
         {
-            if (!inputFile.is_open())
-            {
-                inputFile.open(arg.c_str(), std::ifstream::binary);
-                if (!inputFile.is_open())
-                {
-                    std::cerr << "Failed to open input \"" << arg << "\"" << std::endl;
-                    return 1;
-                }
-            }
-            else if (!outputFile.is_open())
-            {
-                outputFile.open(arg.c_str(), std::ofstream::binary);
-                if (!outputFile.is_open())
-                {
-                    std::cerr << "Failed to open output \"" << arg << "\"" << std::endl;
-                    return 1;
-                }
-            }
+            if (inputFileName.empty())
+                inputFileName = arg;
+            else if (job.outputFileName.empty())
+                job.outputFileName = arg;
             else
                 std::cerr << "Illegal command argument \"" << arg << "\"" << std::endl;
         }
@@ -126,154 +212,541 @@ int main(int argc, char **argv)
             }
             inputStartTime = std::chrono::system_clock::from_time_t(mktime(&t));
         }
+        else if (arg.find(InputFileArg) == 0)
+            inputFileNames.push_back(arg.substr(sizeof(InputFileArg) - 1));
         else if (arg.find(InputIsFlippedArg) == 0)
             inputIQflipped = true;
-        else if (arg.find(OutputCenterKHzArg) == 0)
-            outputCenterKHz = atof(arg.substr(sizeof(OutputCenterKHzArg) - 1).c_str());
-        else if (arg.find(OutputStartTimeArg) == 0)
+        else if (arg.find(ManifestArg) == 0)
+            manifestFileName = arg.substr(sizeof(ManifestArg) - 1);
+        else if (arg.find(ThreadsArg) == 0)
         {
-            std::tm t = {};
-            std::istringstream iss(arg.substr(sizeof(OutputStartTimeArg) - 1));
-            iss >> std::get_time(&t, DateFormatDescriptor);
-            if (iss.fail())
+            int n = atoi(arg.substr(sizeof(ThreadsArg) - 1).c_str());
+            if (n < 1)
             {
-                std::cerr << "Failed to parse time \"" << arg << "\"" << std::endl;
+                std::cerr << arg << " must be at least one" << std::endl;
                 return 1;
             }
-            outputStartTime = std::chrono::system_clock::from_time_t(mktime(&t));
-            outputStartTimeSpecified = true;
+            threads = static_cast<unsigned>(n);
         }
-        else if (arg.find(OutputIntervalSecondsArg) == 0)
+        else if (arg.find(InputReaderArg) == 0)
         {
-            outputInterval = std::chrono::seconds(atoi(arg.substr(sizeof(OutputIntervalSecondsArg) - 1).c_str()));
-            if (outputInterval < std::chrono::seconds(0))
+            std::string v = arg.substr(sizeof(InputReaderArg) - 1);
+            if (v == "map")
+                inputReader = InputReaderType::MAP;
+            else if (v == "readahead")
+                inputReader = InputReaderType::READ_AHEAD;
+            else if (v == "stream")
+                inputReader = InputReaderType::STREAM;
+            else
             {
-                std::cerr << arg << " cannot be less than zero" << std::endl;
+                std::cerr << "Unrecognized input reader \"" << v << "\"" << std::endl;
                 return 1;
             }
         }
-        else if (arg.find(OutputStartSecondsArg) == 0)
+        else if (arg == FollowArg)
+            followSeconds = FOLLOW_IDLE_SECONDS;
+        else if (arg.find(FollowArg) == 0 && arg[sizeof(FollowArg) - 1] == '=')
         {
-            outputStartOffset = std::chrono::seconds(atoi(arg.substr(sizeof(OutputStartSecondsArg) - 1).c_str()));
-            if (outputStartOffset < std::chrono::seconds(0))
+            int n = atoi(arg.substr(sizeof(FollowArg)).c_str());
+            if (n < 1)
             {
-                std::cerr << arg << " cannot be less than zero" << std::endl;
+                std::cerr << arg << " must be at least one second" << std::endl;
                 return 1;
             }
+            followSeconds = static_cast<unsigned>(n);
         }
         else
         {
-            std::cerr << "Unrecognized command argument: \"" << arg << "\"" << std::endl;
-            return 1;
+            int handled = parseOutputArg(arg, job);
+            if (handled < 0)
+                return 1;
+            if (handled == 0)
+            {
+                std::cerr << "Unrecognized command argument: \"" << arg << "\"" << std::endl;
+                return 1;
+            }
         }
     }
 
     // validate command line arguments
-    if (!inputFile.is_open())
+    if (inputFileName.empty())
     {
         std::cerr << "No input file specified" << std::endl;
         usage();
         return 1;
     }
-    if (!outputFile.is_open())
+    inputFileNames.insert(inputFileNames.begin(), inputFileName);
+    if (threads > 1 && followSeconds != 0)
     {
-        std::cerr << "No output file specified" << std::endl;
-        usage();
+        std::cerr << ThreadsArg << " cannot be combined with " << FollowArg << std::endl;
         return 1;
     }
-
-    static const float MaxOutputDifferenceKhz = INPUT_IQ_SAMPLES_PER_SECOND / 2000.f;
-    if (fabs(outputCenterKHz - inputCenterKHz) > MaxOutputDifferenceKhz)
+    if (inputFileName == StandardStreamName)
     {
-        std::cerr << "Output center frequency of " << outputCenterKHz << " must be within +/-" << MaxOutputDifferenceKhz << "KHz of " << inputCenterKHz << std::endl;
-        return 1;
+        if (threads > 1 || followSeconds != 0)
+        {
+            std::cerr << "Standard input cannot be combined with " << (threads > 1 ? ThreadsArg : FollowArg) << std::endl;
+            return 1;
+        }
+        inputReader = InputReaderType::STREAM; // the only one that doesn't seek
     }
 
-    if (outputStartTimeSpecified)
+    std::vector<SliceJob> jobs;
+    if (!manifestFileName.empty())
     {
-        if (outputStartTime < inputStartTime)
+        if (!job.outputFileName.empty())
         {
-            std::cerr << "Output start time must be after Input start time" << std::endl;
+            std::cerr << "Output file \"" << job.outputFileName << "\" cannot be combined with " << ManifestArg << std::endl;
             return 1;
         }
-        outputStartOffset = outputStartTime - inputStartTime;
+        if (!readManifest(manifestFileName, jobs))
+            return 1;
     }
     else
-        outputStartTime = inputStartTime + outputStartOffset;
-
-    unsigned inputFramesToSkip = static_cast<unsigned>(INPUT_IQ_SAMPLES_PER_SECOND * std::chrono::duration_cast<std::chrono::seconds>(outputStartOffset).count());
+    {
+        if (job.outputFileName.empty())
+        {
+            std::cerr << "No output file specified" << std::endl;
+            usage();
+            return 1;
+        }
+        jobs.push_back(job);
+    }
 
-    unsigned inputFramesToProcess = static_cast<unsigned>(INPUT_IQ_SAMPLES_PER_SECOND * std::chrono::duration_cast<std::chrono::seconds>(outputInterval).count());
-    if (inputFramesToProcess == 0) // special case zero to mean process all remaining frames
-        inputFramesToProcess = static_cast<unsigned>(-1l);
+    unsigned toStandardOutput = 0;
+    for (auto& j : jobs)
+    {
+        if (!resolveJob(j, inputCenterKHz, inputStartTime))
+            return 1;
+        if (threads > 1 && j.channelize)
+        {
+            std::cerr << ThreadsArg << " cannot be combined with " << ChannelizeArg << std::endl;
+            return 1;
+        }
+        if (j.outputFileName == StandardStreamName)
+        {
+            if (j.channelize || threads > 1 || ++toStandardOutput > 1)
+            {
+                std::cerr << "Standard output can only be one output, and cannot be combined with " << 
+                    ChannelizeArg << " or " << ThreadsArg << std::endl;
+                return 1;
+            }
+        }
+    }
 
-    return process(inputFile, inputCenterKHz,  inputStartTime,
-         inputFramesToSkip,  inputFramesToProcess,  outputFile, outputCenterKHz,
-         outputStartTime);
+    return process(inputFileNames, inputCenterKHz, jobs, threads, inputReader, followSeconds);
 }
 
-namespace Filter_Octave {
-    const int SAMPLEFILTER_TAP_NUM(401);
-    extern FilterCoeficient_t filter_taps[];
+namespace {
+    // returns 1 if arg is one of the per-output arguments, 0 if not, and -1 if it is but is invalid.
+    int parseOutputArg(const std::string& arg, SliceJob& job)
+    {
+        if (arg.find(OutputCenterKHzArg) == 0)
+            job.outputCenterKHz = atof(arg.substr(sizeof(OutputCenterKHzArg) - 1).c_str());
+        else if (arg.find(OutputStartTimeArg) == 0)
+        {
+            std::tm t = {};
+            std::istringstream iss(arg.substr(sizeof(OutputStartTimeArg) - 1));
+            iss >> std::get_time(&t, DateFormatDescriptor);
+            if (iss.fail())
+            {
+                std::cerr << "Failed to parse time \"" << arg << "\"" << std::endl;
+                return -1;
+            }
+            job.outputStartTime = std::chrono::system_clock::from_time_t(mktime(&t));
+            job.outputStartTimeSpecified = true;
+        }
+        else if (arg.find(OutputIntervalSecondsArg) == 0)
+        {
+            job.outputInterval = std::chrono::seconds(atoi(arg.substr(sizeof(OutputIntervalSecondsArg) - 1).c_str()));
+            if (job.outputInterval < std::chrono::seconds(0))
+            {
+                std::cerr << arg << " cannot be less than zero" << std::endl;
+                return -1;
+            }
+        }
+        else if (arg.find(DecimatorArg) == 0)
+        {
+            std::string v = arg.substr(sizeof(DecimatorArg) - 1);
+            if (v == "fir")
+                job.decimatorType = DecimatorType::FIR;
+            else if (v == "halfband")
+                job.decimatorType = DecimatorType::HALFBAND;
+            else if (v == "cic")
+                job.decimatorType = DecimatorType::CIC;
+            else if (v == "bandpass")
+                job.decimatorType = DecimatorType::BANDPASS;
+            else
+            {
+                std::cerr << "Unrecognized decimator \"" << v << "\"" << std::endl;
+                return -1;
+            }
+        }
+        else if (arg.find(ChannelizeArg) == 0)
+            job.channelize = true;
+        else if (arg.find(OutputFormatArg) == 0)
+        {
+            std::string v = arg.substr(sizeof(OutputFormatArg) - 1);
+            if (v == "wav")
+                job.outputContainer = RiffReader::RIFF;
+            else if (v == "rf64")
+                job.outputContainer = RiffReader::RF64;
+            else if (v == "w64")
+                job.outputContainer = RiffReader::WAVE64;
+            else
+            {
+                std::cerr << "Unrecognized output format \"" << v << "\"" << std::endl;
+                return -1;
+            }
+        }
+        else if (arg.find(OutputStartSecondsArg) == 0)
+        {
+            job.outputStartOffset = std::chrono::seconds(atoi(arg.substr(sizeof(OutputStartSecondsArg) - 1).c_str()));
+            if (job.outputStartOffset < std::chrono::seconds(0))
+            {
+                std::cerr << arg << " cannot be less than zero" << std::endl;
+                return -1;
+            }
+        }
+        else
+            return 0;
+        return 1;
+    }
+
+    bool resolveJob(SliceJob& job, double inputCenterKHz, std::chrono::system_clock::time_point inputStartTime)
+    {
+        static const float MaxOutputDifferenceKhz = INPUT_IQ_SAMPLES_PER_SECOND / 2000.f;
+        if (!job.channelize && fabs(job.outputCenterKHz - inputCenterKHz) > MaxOutputDifferenceKhz)
+        {
+            std::cerr << "Output center frequency of " << job.outputCenterKHz << " must be within +/-" << MaxOutputDifferenceKhz << "KHz of " << inputCenterKHz << std::endl;
+            return false;
+        }
+
+        if (job.outputStartTimeSpecified)
+        {
+            if (job.outputStartTime < inputStartTime)
+            {
+                std::cerr << "Output start time must be after Input start time" << std::endl;
+                return false;
+            }
+            job.outputStartOffset = job.outputStartTime - inputStartTime;
+        }
+        else
+            job.outputStartTime = inputStartTime + job.outputStartOffset;
+
+        job.inputFramesToSkip = static_cast<uint64_t>(INPUT_IQ_SAMPLES_PER_SECOND * std::chrono::duration_cast<std::chrono::seconds>(job.outputStartOffset).count());
+
+        job.inputFramesToProcess = static_cast<uint64_t>(INPUT_IQ_SAMPLES_PER_SECOND * std::chrono::duration_cast<std::chrono::seconds>(job.outputInterval).count());
+        if (job.inputFramesToProcess == 0) // special case zero to mean process all remaining frames
+            job.inputFramesToProcess = UINT64_MAX;
+        return true;
+    }
+
+    bool readManifest(const std::string& manifestFileName, std::vector<SliceJob>& jobs)
+    {
+        std::ifstream manifest(manifestFileName.c_str());
+        if (!manifest.is_open())
+        {
+            std::cerr << "Failed to open manifest \"" << manifestFileName << "\"" << std::endl;
+            return false;
+        }
+        std::string line;
+        for (unsigned lineNumber = 1; std::getline(manifest, line); lineNumber++)
+        {
+            std::istringstream iss(line);
+            std::string arg;
+            SliceJob job;
+            bool hasArgs = false;
+            while ((iss >> arg) && arg[0] != '#') // # to end of line is a comment
+            {
+                hasArgs = true;
+                if (arg.find("--") != 0)
+                {
+                    if (!job.outputFileName.empty())
+                    {
+                        std::cerr << manifestFileName << "(" << lineNumber << "): more than one output file" << std::endl;
+                        return false;
+                    }
+                    job.outputFileName = arg;
+                    continue;
+                }
+                int handled = parseOutputArg(arg, job);
+                if (handled == 0)
+                    std::cerr << "Unrecognized manifest argument: \"" << arg << "\"" << std::endl;
+                if (handled <= 0)
+                {
+                    std::cerr << manifestFileName << "(" << lineNumber << ")" << std::endl;
+                    return false;
+                }
+            }
+            if (job.outputFileName.empty())
+            {
+                if (hasArgs)
+                {
+                    std::cerr << manifestFileName << "(" << lineNumber << "): no output file" << std::endl;
+                    return false;
+                }
+                continue;
+            }
+            jobs.push_back(job);
+        }
+        if (jobs.empty())
+        {
+            std::cerr << "Manifest \"" << manifestFileName << "\" has no jobs" << std::endl;
+            return false;
+        }
+        return true;
+    }
 }
 
 namespace {
     const int OUTPUT_CHUNK_FRAME_COUNT = 2048;
     const int STEREO = 2;
+
+    // Takes mixed I/Q at the input rate and low pass filters it down to the output rate.
+    struct IQDecimator {
+        virtual ~IQDecimator() {};
+        // returns true when outI/outQ are set to the next output frame
+        virtual bool applySample(double inI, double inQ, double& outI, double& outQ) = 0;
+        // true if applySample takes the input before the mix, and does the mix itself.
+        virtual bool MixesOutput() const { return false; }
+        // The next applySample is for this input frame, counted from the start of the output.
+        // Always a multiple of DECIMATE, so only a decimator that mixes needs to know.
+        virtual void SetInputFrame(uint64_t) {}
+        // How many input frames ahead of the fir decimator this one must be fed so that its outputs
+        // line up in time with the fir decimator's. That is, the extra group delay of its filters.
+        virtual unsigned get_inputLead() const { return 0; }
+        // applySample on numFrames of I/Q. The outputs go to outI/outQ, at most numFrames / DECIMATE + 1 of them,
+        // and the return value is how many.
+        virtual unsigned applyBlock(const double* inI, const double* inQ, unsigned numFrames, double* outI, double* outQ)
+        {
+            unsigned numOut = 0;
+            for (unsigned i = 0; i < numFrames; i++)
+                if (applySample(inI[i], inQ[i], outI[numOut], outQ[numOut]))
+                    numOut += 1;
+            return numOut;
+        }
+    };
+
+    // The original single stage: the Octave designed filter run at the input rate
+    // and evaluated on every DECIMATE'th sample. Output n is centered on input frame
+    // n * DECIMATE + FIR_FIRST_OUTPUT_CENTER, which the other decimators match.
+    const int FIR_FIRST_OUTPUT_CENTER = DECIMATE - 1 - Filter_Octave::SAMPLEFILTER_TAP_NUM / 2;
+
+    class FirDecimator : public IQDecimator
+    {
+    public:
+        FirDecimator() : m_bandPassFilters(STEREO)
+        {
+            // The I and Q are identical to each other
+            for (auto& f : m_bandPassFilters)
+                f.setFilterDefinition(Filter_Octave::SAMPLEFILTER_TAP_NUM, Filter_Octave::filter_taps);
+        }
+        bool applySample(double inI, double inQ, double& outI, double& outQ) override
+        {
+            return applyBlock(&inI, &inQ, 1, &outI, &outQ) != 0;
+        }
+        unsigned applyBlock(const double* inI, const double* inQ, unsigned numFrames, double* outI, double* outQ) override
+        {
+            // low pass the mixed I separate from the mixed Q. Both see the same number
+            // of samples, so they output on the same ones.
+            m_bandPassFilters[0].applyBlock(inI, numFrames, outI, DECIMATE);
+            return m_bandPassFilters[1].applyBlock(inQ, numFrames, outQ, DECIMATE);
+        }
+    private:
+        std::vector<CFIRFilter> m_bandPassFilters;
+    };
+
+    class HalfbandChainDecimator : public IQDecimator
+    {
+    public:
+        HalfbandChainDecimator(bool useCic)
+            : m_chain(INPUT_IQ_SAMPLES_PER_SECOND, OUTPUT_IQ_SAMPLES_PER_SECOND, Filter_Octave::PASSBAND_HZ, useCic)
+        {
+            const double lead = FIR_FIRST_OUTPUT_CENTER - m_chain.get_firstOutputCenter();
+            if (lead < 0 || lead != floor(lead))
+                throw std::runtime_error("Decimation chain cannot be aligned with the fir decimator");
+            m_inputLead = static_cast<unsigned>(lead);
+        }
+        bool applySample(double inI, double inQ, double& outI, double& outQ) override
+        {   return m_chain.applySample(inI, inQ, outI, outQ);   }
+        unsigned get_inputLead() const override { return m_inputLead; }
+    private:
+        CDecimationChain m_chain;
+        unsigned m_inputLead;
+    };
+
+    /* Mix after decimation.
+    ** The input mix multiplies sample n by m[n] = A * exp(-j w n) (where A is the constant phase of
+    ** the mix oscillator, see CNco::TablePhase) and then low passes with the real taps h[] of Filter_Octave:
+    **      y[n] = sum(k) h[k] * m[n-k] * x[n-k]
+    **           = A * exp(-j w n) * sum(k) (h[k] * exp(j w k)) * x[n-k]
+    ** So the same output comes from filtering the unmixed input with the complex bandpass taps
+    ** h[k] * exp(j w k), evaluated only at the DECIMATE'th samples, followed by a mix at the output rate.
+    ** h[] is symmetric about its center, c, so the taps at c-i and c+i are h[c+i] * exp(j w c) * exp(+/-j w i), 
+    ** and each such pair costs the same 4 multiplies as the pair of real taps did for I and Q:
+    **      exp(j w i) * a + exp(-j w i) * b = cos(w i) * (a + b) + j * sin(w i) * (a - b)
+    ** The exp(j w c) is also moved into the output mix.
+    **
+    ** The output mix is a CNco at the same frequency as the fir decimator's input mix, so the result
+    ** matches the fir decimator to within 1e-6 of full scale. (In practice the two differ only by
+    ** double precision rounding, which rarely reaches the last bit of the float output samples.)
+    */
+    class BandpassDecimator : public IQDecimator
+    {
+    public:
+        BandpassDecimator(double mixKhz)
+            : m_len(Filter_Octave::SAMPLEFILTER_TAP_NUM)
+            , m_center(Filter_Octave::filter_taps[Filter_Octave::SAMPLEFILTER_TAP_NUM / 2])
+            , m_historyI(2 * Filter_Octave::SAMPLEFILTER_TAP_NUM, 0.)
+            , m_historyQ(2 * Filter_Octave::SAMPLEFILTER_TAP_NUM, 0.)
+            , m_lastIndex(0)
+            , m_outputDecimate(0)
+            , m_outputMix(INPUT_IQ_SAMPLES_PER_SECOND)
+        {
+            static const double TwoPi = 2. * 3.14159265358979323846264338;
+            m_mixHz = mixKhz * 1000;
+            m_outputMix.SetFrequency(-m_mixHz);
+            SetInputFrame(0);
+            const unsigned half = m_len / 2;
+            for (unsigned i = 1; i <= half; i++)
+            {
+                const FilterCoeficient_t h = Filter_Octave::filter_taps[half + i];
+                if (h != Filter_Octave::filter_taps[half - i])
+                    throw std::runtime_error("Bandpass decimator requires symmetric filter taps");
+                double w = TwoPi * m_mixHz * static_cast<double>(i) / INPUT_IQ_SAMPLES_PER_SECOND;
+                m_tapsCos.push_back(h * cos(w));
+                m_tapsSin.push_back(h * sin(w));
+            }
+        }
+
+        bool MixesOutput() const override { return true; }
+
+        void SetInputFrame(uint64_t inputFrame) override
+        {   // position the output mix at the sample in the center of the first output's history
+            const int64_t half = m_len / 2;
+            m_outputMix.SetPhase(CNco::TablePhase(m_mixHz));
+            m_outputMix.Skip(static_cast<int64_t>(inputFrame) + DECIMATE - 1 - half);
+        }
+
+        bool applySample(double inI, double inQ, double& outI, double& outQ) override
+        {
+            m_historyI[m_lastIndex] = inI;
+            m_historyI[m_lastIndex + m_len] = inI;
+            m_historyQ[m_lastIndex] = inQ;
+            m_historyQ[m_lastIndex + m_len] = inQ;
+            if (++m_lastIndex >= m_len)
+                m_lastIndex = 0;
+            if (++m_outputDecimate < DECIMATE)
+                return false;
+            m_outputDecimate = 0;
+
+            // the doubled history puts the center tap at m_lastIndex + half, the
+            // newer samples above it and the older below, with no wrap check.
+            const unsigned half = m_len / 2;
+            const double* pI = &m_historyI[m_lastIndex + half];
+            const double* pQ = &m_historyQ[m_lastIndex + half];
+            double vI = m_center * *pI;
+            double vQ = m_center * *pQ;
+            for (unsigned i = 1; i <= half; i++)
+            {
+                double a = pI[-static_cast<int>(i)];
+                double b = pI[i];
+                double sumI = a + b;
+                double difI = a - b;
+                a = pQ[-static_cast<int>(i)];
+                b = pQ[i];
+                double sumQ = a + b;
+                double difQ = a - b;
+                double c = m_tapsCos[i - 1];
+                double sn = m_tapsSin[i - 1];
+                vI += c * sumI - sn * difQ;
+                vQ += c * sumQ + sn * difI;
+            }
+
+            // now the mix at the output rate: A * exp(-j w (n - c)) for n the newest sample
+            auto v = m_outputMix.Value() * std::complex<double>(vI, vQ);
+            m_outputMix.Skip(DECIMATE);
+            outI = v.real();
+            outQ = v.imag();
+            return true;
+        }
+    private:
+        const unsigned m_len;
+        const double m_center;
+        std::vector<double> m_tapsCos;
+        std::vector<double> m_tapsSin;
+        std::vector<double> m_historyI;
+        std::vector<double> m_historyQ;
+        unsigned m_lastIndex;
+        unsigned m_outputDecimate;
+        double m_mixHz;
+        CNco m_outputMix;
+    };
+
+    std::unique_ptr<IQDecimator> makeDecimator(DecimatorType t, double mixKhz)
+    {
+        switch (t)
+        {
+        case DecimatorType::BANDPASS:
+            return std::unique_ptr<IQDecimator>(new BandpassDecimator(mixKhz));
+        case DecimatorType::HALFBAND:
+            return std::unique_ptr<IQDecimator>(new HalfbandChainDecimator(false));
+        case DecimatorType::CIC:
+            return std::unique_ptr<IQDecimator>(new HalfbandChainDecimator(true));
+        default:
+            return std::unique_ptr<IQDecimator>(new FirDecimator());
+        }
+    }
+
     struct NextBuffer {
         virtual ~NextBuffer() {};
         virtual void ProcessChunk(unsigned char* p, unsigned sze) = 0;
+        virtual void Flush() = 0; // write out what has been processed so far
         virtual void Finish() = 0;
     };
     
-    template <class Sample_t, unsigned SCALE=1>
-    class Process : public NextBuffer
+    // Writes the 12KHz stereo float output WAV file. The file writes happen on a background
+    // thread (see CAsyncWriter) so they never hold up the DSP.
+    class WavOutput
     {
     public:
-        Process(std::ofstream& outputFile, double mixKhz, double outputCenterKHz,
-            std::chrono::system_clock::time_point outputStartTime)
-            : m_outputFile(outputFile)
-            , m_MixIindex(0)
-            , m_MixQindex(0)
-            , m_QScale(1)
-            , m_bandPassFilters(STEREO) // one for I one for Q 
-            , m_outputDecimate(0)
+        // expectedFrames, if not zero, is the number of frames to expect. The header is written 
+        // with the sizes for that many, and the disk space is preallocated.
+        // A RIFF container too small for expectedFrames is written as RF64 instead.
+        WavOutput(const std::string& outputFileName, double outputCenterKHz,
+            std::chrono::system_clock::time_point outputStartTime, uint64_t expectedFrames, RiffReader::Container container)
+            : m_outputFileName(outputFileName)
             , m_outputBuffer(OUTPUT_CHUNK_FRAME_COUNT* STEREO)
             , m_outputBufferPosition(0)
             , m_dataChunkByteCountPos(0)
+            , m_dataPosition(0)
+            , m_ds64Pos(0)
             , m_dataChunkByteCount(0)
+            , m_expectedDataChunkByteCount(expectedFrames * STEREO * sizeof(float))
+            , m_container(container == RiffReader::RIFF && m_expectedDataChunkByteCount > MAX_RIFF_DATA_BYTES ?
+                RiffReader::RF64 : container)
+            , m_writesHeader(true)
         {
-            // initialize precomputed sin/cos for the mix to outputCenterKHz
-            // populate the sine table.
-            // use the same table for cosine but start in different position.
-            int mixF = static_cast<int>(mixKhz * 1000);
-            bool isNeg = mixKhz < 0;
-            if (isNeg)
-                mixF = -mixF;
-            m_QScale = isNeg ? -1.f : 1.f;
-
-            bool closestOneNeg = PrecomputeSinCos::ComputeSinCos(
-                INPUT_IQ_SAMPLES_PER_SECOND, mixF, m_MixCoef, m_MixQindex);
-            if (mixF != 0)
-            {
-                if (closestOneNeg)
-                    m_QScale *= -1.f;// flip mixQ summation if we're using upside-down cosine
+            if (!m_outputFile.Open(outputFileName))
+                throw std::runtime_error("Failed to open output \"" + outputFileName + "\"");
+            auto& outputFile = m_outputFile;
+            // The sizes are all zero for now. (RF64's 32 bit ones are 0xFFFFFFFF, for good.)
+            static const char* riffTag[] = { "RIFF", "RF64", "riff" };
+            writeChunkHeader(riffTag[m_container], 0); // RIFF size goes here
+            writeTag(m_container == RiffReader::WAVE64 ? "wave" : "WAVE");
+            if (m_container == RiffReader::RF64)
+            {   // where the 64 bit sizes go
+                writeChunkHeader("ds64", DS64_CHUNK_BYTES);
+                m_ds64Pos = outputFile.get_position();
+                std::vector<char> ds64(DS64_CHUNK_BYTES);
+                outputFile.Write(&ds64[0], ds64.size());
             }
-
-            // set up bandpass filters. The I and Q are identical to each other
-            for (auto& f : m_bandPassFilters)
-                f.setFilterDefinition(Filter_Octave::SAMPLEFILTER_TAP_NUM, Filter_Octave::filter_taps);
-
-            // initialize output WAV file
-            outputFile.write("RIFF", 4);
             std::vector<char> buf(4);
-            outputFile.write(&buf[0], 4);
-            outputFile.write("WAVE", 4);
             // FORMATETC
-            outputFile.write("fmt ", 4); 
-            outputFile.write("\020\0\0\0", 4); // 16 byte chunk size
-            outputFile.write("\03\0", 2); // format number 3 -- float samples
-            outputFile.write("\02\0", 2); // 2 channels = stereo
+            writeChunkHeader("fmt ", 16);
+            outputFile.Write("\03\0", 2); // format number 3 -- float samples
+            outputFile.Write("\02\0", 2); // 2 channels = stereo
             uint32_t rate = OUTPUT_IQ_SAMPLES_PER_SECOND;
             uint16_t bitsPerSample = 8 * sizeof(float);
             uint16_t blockAlign = 2 * sizeof(float);
@@ -283,19 +756,19 @@ namespace {
             buf[1] = static_cast<char>(rate >> 8);
             buf[2] = static_cast<char>(rate >> 16);
             buf[3] = static_cast<char>(rate >> 24);
-            outputFile.write(&buf[0], 4);
+            outputFile.Write(&buf[0], 4);
 
             buf[0] = static_cast<char>(byteRate);
             buf[1] = static_cast<char>(byteRate>>8);
             buf[2] = static_cast<char>(byteRate>>16);
             buf[3] = static_cast<char>(byteRate>>24);
-            outputFile.write(&buf[0], 4);
+            outputFile.Write(&buf[0], 4);
             buf[0] = static_cast<char>(blockAlign);
             buf[1] = static_cast<char>(blockAlign >> 8);
-            outputFile.write(&buf[0], 2);
+            outputFile.Write(&buf[0], 2);
             buf[0] = static_cast<char>(bitsPerSample);
             buf[1] = static_cast<char>(bitsPerSample >> 8);
-            outputFile.write(&buf[0], 2);
+            outputFile.Write(&buf[0], 2);
             // FORMATETC done
 
             // Write stuff in "0SDR" chunk so ReviewRecordedIQ can see what we did here.
@@ -307,127 +780,721 @@ namespace {
             std::ostringstream oss;
             oss << "--outputStartTime=" << std::put_time(&tm, DateFormatDescriptor);
             oss << " --outputCenterKHz=" << outputCenterKHz;
-            outputFile.write("0SDR", 4); // 0SDR chunk to show the parameters we used
             unsigned SdrChunkSize = static_cast<unsigned>(oss.str().length());
             // make the chunksize a multiple of 16. have no idea if this is necessary,
             // but I am not going to mess up the alignment
             SdrChunkSize += 15;
             SdrChunkSize <<= 4;
             SdrChunkSize >>= 4;
+            if (m_container == RiffReader::WAVE64)
+                SdrChunkSize = (SdrChunkSize + 7) / 8 * 8; // Wave64 chunks are 8 byte aligned
             while (oss.str().length() < SdrChunkSize)
                 oss << " ";
-            buf[0] = static_cast<char>(SdrChunkSize);
-            buf[1] = static_cast<char>(SdrChunkSize>>8);
-            buf[2] = static_cast<char>(SdrChunkSize>>16);
-            buf[3] = static_cast<char>(SdrChunkSize>>24);
-            outputFile.write(&buf[0], buf.size());
-            outputFile.write(oss.str().c_str(), SdrChunkSize);
+            writeChunkHeader("0SDR", SdrChunkSize); // 0SDR chunk to show the parameters we used
+            outputFile.Write(oss.str().c_str(), SdrChunkSize);
 
-            outputFile.write("data", 4); // start the required, final 'data' chunk
-            m_dataChunkByteCountPos = outputFile.tellp();
-            memset(&buf[0], 0, 4);
-            outputFile.write(&buf[0], 4);
+            // start the required, final 'data' chunk
+            m_dataChunkByteCountPos = writeChunkHeader("data", 0); // data size goes here
+            m_dataPosition = outputFile.get_position();
+            if (m_expectedDataChunkByteCount != 0)
+            {   // The sizes are known now, so Finish won't need to seek back for them (unless the input runs out early)
+                writeSizes(m_expectedDataChunkByteCount);
+                outputFile.Seek(get_dataPosition());
+                outputFile.Preallocate(get_dataPosition() + m_expectedDataChunkByteCount);
+            }
+            else if (!outputFile.get_seekable())
+            {   // Finish won't be able to seek back either. The sizes say to read to the end of the stream
+                writeStreamingSizes();
+                outputFile.Seek(get_dataPosition());
+            }
         }
 
-        void ProcessChunk(unsigned char* p, unsigned numFrames)
+        // Writes only sample data, starting at dataPosition in a file whose header
+        // some other WavOutput writes.
+        WavOutput(const std::string& outputFileName, uint64_t dataPosition)
+            : m_outputFileName(outputFileName)
+            , m_outputBuffer(OUTPUT_CHUNK_FRAME_COUNT* STEREO)
+            , m_outputBufferPosition(0)
+            , m_dataChunkByteCountPos(0)
+            , m_dataPosition(0)
+            , m_ds64Pos(0)
+            , m_dataChunkByteCount(0)
+            , m_expectedDataChunkByteCount(0)
+            , m_container(RiffReader::RIFF) // the header's WavOutput has the real one
+            , m_writesHeader(false)
         {
-            // TODO--If we're running on a big-endian machine, the byte-swapping codes of *p go here...
-            for (auto q = reinterpret_cast<Sample_t*>(p); numFrames > 0 ; numFrames -= 1)
-            {
-                float inI = static_cast<float>(*q++);
-                float inQ = static_cast<float>(*q++);
+            // open without truncating what the others are writing
+            if (!m_outputFile.Open(outputFileName, false))
+                throw std::runtime_error("Failed to open output \"" + outputFileName + "\"");
+            m_outputFile.Seek(dataPosition);
+        }
 
-                unsigned sze = static_cast<unsigned>(m_MixCoef.size());
-                double mixI = m_MixCoef[m_MixIindex++];
-                if (m_MixIindex >= sze)
-                    m_MixIindex = 0;
-                double mixQ = m_MixCoef[m_MixQindex++];
-                if (m_MixQindex >= sze)
-                    m_MixQindex = 0;
-                mixQ *= m_QScale; // flip for negative mixer frequency
+        // where the sample data starts
+        uint64_t get_dataPosition() const { return m_dataPosition; }
 
-                // The mix is a complex multiply
-                double nextI = inI * mixI - inQ * mixQ;
-                double nextQ = inQ * mixI + inI * mixQ;
+        // Count data that other WavOutputs wrote into this file
+        void AddSegmentBytes(uint64_t byteCount) { m_dataChunkByteCount += byteCount; }
 
-                // low pass the mixed I separate from the mixed Q
-                m_bandPassFilters[0].applySample(nextI);
-                m_bandPassFilters[1].applySample(nextQ);
-                m_outputDecimate += 1;
-                if (m_outputDecimate >= DECIMATE)
-                {
-                    m_outputDecimate = 0;
-                    auto outI = m_bandPassFilters[0].value();
-                    auto outQ = m_bandPassFilters[1].value();
-                    // TODO..output buffer must be little endian. Big endian machine must fix.
-                    m_outputBuffer[m_outputBufferPosition++] = static_cast<float>(outI);
-                    m_outputBuffer[m_outputBufferPosition++] = static_cast<float>(outQ);
-                    if (m_outputBufferPosition >= m_outputBuffer.size())
-                        writeDataChunk();
-                }
-            }
+        void Write(double outI, double outQ)
+        {
+            // TODO..output buffer must be little endian. Big endian machine must fix.
+            m_outputBuffer[m_outputBufferPosition++] = static_cast<float>(outI);
+            m_outputBuffer[m_outputBufferPosition++] = static_cast<float>(outQ);
+            if (m_outputBufferPosition >= m_outputBuffer.size())
+                writeDataChunk();
         }
-        
+
+        // Get everything so far into the file, for whatever is reading it while it is still being written.
+        // The header's sizes are not touched.
+        void Flush()
+        {
+            if (m_outputBufferPosition > 0)
+                writeDataChunk();
+            m_outputFile.Flush();
+        }
+
         void Finish()
         {
             if (m_outputBufferPosition > 0)
                 writeDataChunk();
 
             // RIFF format requires us to seek back into the header of the
-            // file and overwrite two different byte counts.
+            // file and overwrite two different byte counts...unless they were known up front.
+            if (m_writesHeader && m_dataChunkByteCount != m_expectedDataChunkByteCount)
+            {
+                if (!m_outputFile.get_seekable())
+                {   // a pipe, and the header is long gone down it
+                    if (m_dataChunkByteCount < m_expectedDataChunkByteCount)
+                        std::cerr << "Output \"" << m_outputFileName << "\" ended " <<
+                            (m_expectedDataChunkByteCount - m_dataChunkByteCount) / (STEREO * sizeof(float)) <<
+                            " frames short of the size in its header" << std::endl;
+                }
+                else
+                {
+                    if (m_container == RiffReader::RIFF && m_dataChunkByteCount > MAX_RIFF_DATA_BYTES)
+                        std::cerr << "Output \"" << m_outputFileName << "\" is too big for RIFF. Use " << OutputFormatArg << "rf64" << std::endl;
+                    writeSizes(m_dataChunkByteCount);
+                }
+            }
 
-            auto posHere = m_outputFile.tellp();
-            uint32_t RiffChunkSize = static_cast<uint32_t>(posHere);
-            RiffChunkSize -= 8;
-            
-            std::vector<char> buf(4);
-            buf[0] = static_cast<char>(RiffChunkSize);
-            buf[1] = static_cast<char>(RiffChunkSize >> 8);
-            buf[2] = static_cast<char>(RiffChunkSize >> 16);
-            buf[3] = static_cast<char>(RiffChunkSize >> 24);
-            m_outputFile.seekp(4);
-            m_outputFile.write(&buf[0], buf.size());
-
-            buf[0] = static_cast<char>(m_dataChunkByteCount);
-            buf[1] = static_cast<char>(m_dataChunkByteCount >> 8);
-            buf[2] = static_cast<char>(m_dataChunkByteCount >> 16);
-            buf[3] = static_cast<char>(m_dataChunkByteCount >> 24);
-            m_outputFile.seekp(m_dataChunkByteCountPos);
-            m_outputFile.write(&buf[0], buf.size());
-
-            m_outputFile.close();
+            if (!m_outputFile.Close())
+                std::cerr << "Failed writing output \"" << m_outputFileName << "\"" << std::endl;
         }
     private:
-        static const double Scale;
-        std::ofstream& m_outputFile;
-        std::vector<double> m_MixCoef;
-        unsigned m_MixIindex;
-        unsigned m_MixQindex;
-        double m_QScale;
-        std::vector<CFIRFilter> m_bandPassFilters;
-        unsigned m_outputDecimate;
-        unsigned m_outputBufferPosition;
+        static const uint64_t MAX_RIFF_DATA_BYTES = 0xFFFFFFFFu - 0x10000; // leaving room for the header
+        static const unsigned DS64_CHUNK_BYTES = 28; // RIFF size, data size, sample count, and an empty table
+        static const unsigned WAVE64_CHUNK_HEADER_BYTES = 24;
+
+        std::string m_outputFileName;
+        CAsyncWriter m_outputFile;
         std::vector<float> m_outputBuffer;
-        std::streampos m_dataChunkByteCountPos;
-        uint32_t m_dataChunkByteCount;
+        unsigned m_outputBufferPosition;
+        uint64_t m_dataChunkByteCountPos;
+        uint64_t m_dataPosition;
+        uint64_t m_ds64Pos;
+        uint64_t m_dataChunkByteCount;
+        uint64_t m_expectedDataChunkByteCount;
+        const RiffReader::Container m_container;
+        bool m_writesHeader;
+
+        void writeLittleEndian(uint64_t v, unsigned bytes)
+        {
+            char buf[8];
+            for (unsigned i = 0; i < bytes; i++)
+                buf[i] = static_cast<char>(v >> (8 * i));
+            m_outputFile.Write(buf, bytes);
+        }
+
+        // a four character code, or the Wave64 GUID for it
+        void writeTag(const char* fourcc)
+        {
+            if (m_container == RiffReader::WAVE64)
+            {
+                unsigned char guid[16];
+                RiffReader::Wave64Guid(fourcc, guid);
+                m_outputFile.Write(guid, sizeof(guid));
+            }
+            else
+                m_outputFile.Write(fourcc, 4);
+        }
+
+        // Returns the position of the size, to rewrite it later.
+        uint64_t writeChunkHeader(const char* fourcc, uint64_t chunkSize)
+        {
+            writeTag(fourcc);
+            const uint64_t sizePos = m_outputFile.get_position();
+            if (m_container == RiffReader::WAVE64)
+                writeLittleEndian(chunkSize + WAVE64_CHUNK_HEADER_BYTES, 8); // which counts itself
+            else if (m_container == RiffReader::RF64 && (strncmp(fourcc, "RF64", 4) == 0 || strncmp(fourcc, "data", 4) == 0))
+                writeLittleEndian(0xFFFFFFFFu, 4); // see ds64
+            else
+                writeLittleEndian(chunkSize, 4);
+            return sizePos;
+        }
+
+        void writeSizes(uint64_t dataChunkByteCount)
+        {
+            switch (m_container)
+            {
+            case RiffReader::RIFF:
+                m_outputFile.Seek(4);
+                writeLittleEndian(get_dataPosition() + dataChunkByteCount - 8, 4);
+                m_outputFile.Seek(m_dataChunkByteCountPos);
+                writeLittleEndian(dataChunkByteCount, 4);
+                break;
+            case RiffReader::RF64:
+                m_outputFile.Seek(m_ds64Pos);
+                writeLittleEndian(get_dataPosition() + dataChunkByteCount - 8, 8);
+                writeLittleEndian(dataChunkByteCount, 8);
+                writeLittleEndian(dataChunkByteCount / (STEREO * sizeof(float)), 8);
+                break;
+            case RiffReader::WAVE64: // the riff size is the whole file's
+                m_outputFile.Seek(16);
+                writeLittleEndian(get_dataPosition() + dataChunkByteCount, 8);
+                m_outputFile.Seek(m_dataChunkByteCountPos);
+                writeLittleEndian(dataChunkByteCount + WAVE64_CHUNK_HEADER_BYTES, 8);
+                break;
+            }
+        }
+
+        // For a pipe. The RIFF, RF64 or Wave64 sizes, all ones, that mean "to the end of the stream."
+        void writeStreamingSizes()
+        {
+            const uint64_t unknown = UINT64_MAX;
+            switch (m_container)
+            {
+            case RiffReader::RIFF:
+                m_outputFile.Seek(4);
+                writeLittleEndian(unknown, 4);
+                m_outputFile.Seek(m_dataChunkByteCountPos);
+                writeLittleEndian(unknown, 4);
+                break;
+            case RiffReader::RF64:
+                m_outputFile.Seek(m_ds64Pos);
+                writeLittleEndian(unknown, 8);
+                writeLittleEndian(unknown, 8);
+                writeLittleEndian(unknown, 8);
+                break;
+            case RiffReader::WAVE64:
+                m_outputFile.Seek(16);
+                writeLittleEndian(unknown, 8);
+                m_outputFile.Seek(m_dataChunkByteCountPos);
+                writeLittleEndian(unknown, 8);
+                break;
+            }
+        }
 
         void writeDataChunk()
         {
             uint32_t chunkSize = m_outputBufferPosition * sizeof(float);
             m_outputBufferPosition = 0;
-            m_outputFile.write(reinterpret_cast<const char*>(&m_outputBuffer[0]), chunkSize);
+            m_outputFile.Write(&m_outputBuffer[0], chunkSize);
             m_dataChunkByteCount += chunkSize;
         }
     };
 
+    // The input frames a job needs past its end, for its decimator's lead.
+    unsigned inputLead(const SliceJob& job)
+    {
+        if (job.channelize)
+            return 0;
+        return makeDecimator(job.decimatorType, 0)->get_inputLead();
+    }
+
+    // Mixes and decimates one output. The decimator's lead (see IQDecimator::get_inputLead) is handled here:
+    // the first inputLead frames given to ProcessChunk are skipped over, and the caller gives that many
+    // frames past the end of the output's inputFrames, where the input has them. Finish makes up any
+    // it didn't have with silence, so the output has inputFrames / DECIMATE frames, whatever the lead.
+    template <class Sample_t, unsigned SCALE=1>
+    class Process : public NextBuffer
+    {
+    public:
+        // inputFrames is UINT64_MAX for all there are.
+        Process(const std::string& outputFileName, double mixKhz, double outputCenterKHz,
+            std::chrono::system_clock::time_point outputStartTime, DecimatorType decimatorType, uint64_t expectedFrames,
+            RiffReader::Container outputContainer, uint64_t inputFrames)
+            : m_mix(INPUT_IQ_SAMPLES_PER_SECOND)
+            , m_outputsToDiscard(0)
+            , m_decimator(makeDecimator(decimatorType, mixKhz))
+            , m_framesToSkip(m_decimator->get_inputLead())
+            , m_framesToDecimate(inputFrames)
+            , m_framesDecimated(0)
+            , m_framesGiven(0)
+            , m_output(outputFileName, outputCenterKHz, outputStartTime, expectedFrames, outputContainer)
+            , m_blockI(BLOCK_FRAMES)
+            , m_blockQ(BLOCK_FRAMES)
+            , m_outI(BLOCK_FRAMES)
+            , m_outQ(BLOCK_FRAMES)
+            , m_mixCos(BLOCK_FRAMES)
+            , m_mixSin(BLOCK_FRAMES)
+        {
+            initMix(mixKhz);
+        }
+
+        // One segment of an output file split among threads. 
+        Process(const std::string& outputFileName, uint64_t dataPosition, double mixKhz, DecimatorType decimatorType)
+            : m_mix(INPUT_IQ_SAMPLES_PER_SECOND)
+            , m_outputsToDiscard(0)
+            , m_decimator(makeDecimator(decimatorType, mixKhz))
+            , m_framesToSkip(m_decimator->get_inputLead())
+            , m_framesToDecimate(UINT64_MAX)
+            , m_framesDecimated(0)
+            , m_framesGiven(0)
+            , m_output(outputFileName, dataPosition)
+            , m_blockI(BLOCK_FRAMES)
+            , m_blockQ(BLOCK_FRAMES)
+            , m_outI(BLOCK_FRAMES)
+            , m_outQ(BLOCK_FRAMES)
+            , m_mixCos(BLOCK_FRAMES)
+            , m_mixSin(BLOCK_FRAMES)
+        {
+            initMix(mixKhz);
+        }
+
+        // The first frame to ProcessChunk is inputFrame frames from the start of the output, and the
+        // first warmupFrames of them only fill the filter history: their outputs are not written.
+        // Both must be multiples of DECIMATE. inputFrames (including the warmup) are to be decimated,
+        // which ProcessChunk is given along with the lead after them.
+        void StartAt(uint64_t inputFrame, unsigned warmupFrames, uint64_t inputFrames)
+        {
+            if ((inputFrame % DECIMATE) != 0 || (warmupFrames % DECIMATE) != 0)
+                throw std::runtime_error("Process can only start on a multiple of DECIMATE");
+            m_mix.Skip(static_cast<int64_t>(inputFrame));
+            m_decimator->SetInputFrame(inputFrame);
+            m_outputsToDiscard = warmupFrames / DECIMATE;
+            m_framesToDecimate = inputFrames;
+        }
+
+        void ProcessChunk(unsigned char* p, unsigned numFrames)
+        {
+            // TODO--If we're running on a big-endian machine, the byte-swapping codes of *p go here...
+            auto q = reinterpret_cast<const Sample_t*>(p);
+            m_framesGiven += numFrames;
+            if (m_framesToSkip > 0)
+            {   // the decimator sees each frame m_framesToSkip after the fir decimator would
+                unsigned n = std::min(numFrames, m_framesToSkip);
+                m_mix.Skip(n);
+                q += n * STEREO;
+                numFrames -= n;
+                m_framesToSkip -= n;
+            }
+            decimate(q, static_cast<unsigned>(std::min<uint64_t>(numFrames, m_framesToDecimate - m_framesDecimated)));
+        }
+        
+        void Flush()
+        {
+            m_output.Flush();
+        }
+
+        void Finish()
+        {
+            // The input ended before the lead past the end of the output. The rest of the lead is silence.
+            const uint64_t toDecimate = std::min(m_framesGiven, m_framesToDecimate);
+            if (m_framesDecimated < toDecimate)
+            {
+                std::vector<Sample_t> silence(BLOCK_FRAMES * STEREO, 0);
+                while (m_framesDecimated < toDecimate)
+                    decimate(&silence[0], static_cast<unsigned>(std::min<uint64_t>(BLOCK_FRAMES, toDecimate - m_framesDecimated)));
+            }
+            m_output.Finish();
+        }
+    private:
+        enum {BLOCK_FRAMES = 1024};
+
+        void decimate(const Sample_t* q, unsigned numFrames)
+        {
+            m_framesDecimated += numFrames;
+            while (numFrames > 0)
+            {   // mix a block into m_blockI/Q, and then the decimator takes the whole block at once
+                unsigned n = std::min(numFrames, static_cast<unsigned>(BLOCK_FRAMES));
+                q = mixBlock(q, n);
+                unsigned numOut = m_decimator->applyBlock(&m_blockI[0], &m_blockQ[0], n, &m_outI[0], &m_outQ[0]);
+                for (unsigned i = 0; i < numOut; i++)
+                    write(m_outI[i], m_outQ[i]);
+                numFrames -= n;
+            }
+        }
+
+        const Sample_t* mixBlock(const Sample_t* q, unsigned numFrames)
+        {
+            const bool mixHere = !m_decimator->MixesOutput();
+            if (mixHere)
+                m_mix.Generate(&m_mixCos[0], &m_mixSin[0], numFrames);
+            for (unsigned i = 0; i < numFrames; i++)
+            {
+                float inI = static_cast<float>(*q++);
+                float inQ = static_cast<float>(*q++);
+
+                if (!mixHere)
+                {   // the decimator does the mix at the output rate
+                    m_blockI[i] = inI;
+                    m_blockQ[i] = inQ;
+                    continue;
+                }
+
+                double mixI = m_mixCos[i];
+                double mixQ = m_mixSin[i];
+
+                // The mix is a complex multiply
+                double nextI = inI * mixI - inQ * mixQ;
+                double nextQ = inQ * mixI + inI * mixQ;
+
+                m_blockI[i] = nextI;
+                m_blockQ[i] = nextQ;
+            }
+            return q;
+        }
+
+        void write(double outI, double outQ)
+        {
+            if (m_outputsToDiscard > 0)
+                m_outputsToDiscard -= 1;
+            else
+                m_output.Write(outI, outQ);
+        }
+
+        void initMix(double mixKhz)
+        {
+            if (!m_decimator->MixesOutput())
+            {   // the oscillator for the mix to outputCenterKHz
+                double mixHz = mixKhz * 1000;
+                m_mix.SetFrequency(-mixHz);
+                m_mix.SetPhase(CNco::TablePhase(mixHz));
+            }
+        }
+
+        static const double Scale;
+        CNco m_mix;
+        unsigned m_outputsToDiscard;
+        std::unique_ptr<IQDecimator> m_decimator;
+        unsigned m_framesToSkip;
+        uint64_t m_framesToDecimate;
+        uint64_t m_framesDecimated;
+        uint64_t m_framesGiven;
+        WavOutput m_output;
+        std::vector<double> m_blockI;
+        std::vector<double> m_blockQ;
+        std::vector<double> m_outI;
+        std::vector<double> m_outQ;
+        std::vector<double> m_mixCos;
+        std::vector<double> m_mixSin;
+    };
+
     template <class Sample_t, unsigned SCALE >
     const double Process<Sample_t, SCALE>::Scale = 1.0 / SCALE;
 
-    int process(std::ifstream& inputFile, double inputCenterKHz, std::chrono::system_clock::time_point inputStartTime,
-        unsigned inputFramesToSkip, unsigned inputFramesToProcess, std::ofstream& outputFile, double outputCenterKHz,
-        std::chrono::system_clock::time_point outputStartTime)
+    // In place radix 2 FFT with a positive exponent. That is, on return
+    //      v[k] = sum(p) v[p] * exp(j 2 pi k p / N)
+    // twiddle[i] must be exp(j 2 pi i / N) for i < N/2
+    void InverseFFT(std::complex<double>* v, unsigned N, const std::vector<std::complex<double>>& twiddle)
+    {
+        for (unsigned i = 1, j = 0; i < N; i++)
+        {   // bit reversed order
+            unsigned bit = N >> 1;
+            for (; j & bit; bit >>= 1)
+                j ^= bit;
+            j ^= bit;
+            if (i < j)
+                std::swap(v[i], v[j]);
+        }
+        for (unsigned len = 2; len <= N; len <<= 1)
+        {
+            unsigned step = N / len;
+            for (unsigned i = 0; i < N; i += len)
+                for (unsigned k = 0; k < len / 2; k++)
+                {
+                    auto t = v[i + k + len / 2] * twiddle[k * step];
+                    v[i + k + len / 2] = v[i + k] - t;
+                    v[i + k] += t;
+                }
+        }
+    }
+
+    /* Polyphase FFT channelizer.
+    ** Split the input into NUM_CHANNELS outputs, each 12KHz wide and centered on a multiple of 12KHz
+    ** from the input center. With the mix frequency w = 2 pi k / DECIMATE for channel k, the
+    ** output of Process at input sample n = DECIMATE * m + DECIMATE - 1 is
+    **      y[k] = A * exp(-j w n) * sum(i) h[i] * exp(j w i) * x[n-i]
+    ** Split i = DECIMATE * r + p, and note exp(j w DECIMATE r) = 1:
+    **      y[k] = A * exp(-j w n) * sum(p) exp(j 2 pi k p / DECIMATE) * v[p]
+    **      v[p] = sum(r) h[DECIMATE * r + p] * x[n - DECIMATE * r - p]
+    ** ...which is one pass of the Filter_Octave taps, in DECIMATE polyphase branches, followed by a
+    ** DECIMATE point FFT. The work for all NUM_CHANNELS outputs is barely more than the work for one.
+    ** A * exp(-j w n) is the same constant phase for every output sample of channel k, and
+    ** is applied so the outputs match the single channel Process.
+    */
+    const unsigned NUM_CHANNELS = DECIMATE;
+
+    std::string ChannelFileName(const std::string& outputFileName, double centerKHz)
+    {
+        std::ostringstream oss;
+        oss << "_" << centerKHz;
+        auto dot = outputFileName.rfind('.');
+        auto slash = outputFileName.find_last_of("/\\");
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+            return outputFileName + oss.str();
+        return outputFileName.substr(0, dot) + oss.str() + outputFileName.substr(dot);
+    }
+
+    template <class Sample_t>
+    class Channelizer : public NextBuffer
+    {
+    public:
+        Channelizer(const std::string& outputFileName, double inputCenterKHz,
+            std::chrono::system_clock::time_point outputStartTime, uint64_t expectedFrames, RiffReader::Container outputContainer)
+            : m_len(((Filter_Octave::SAMPLEFILTER_TAP_NUM + NUM_CHANNELS - 1) / NUM_CHANNELS) * NUM_CHANNELS)
+            , m_taps(m_len, 0.)
+            , m_historyI(2 * m_len, 0.)
+            , m_historyQ(2 * m_len, 0.)
+            , m_lastIndex(0)
+            , m_outputDecimate(0)
+            , m_v(NUM_CHANNELS)
+        {
+            static const double TwoPi = 2. * 3.14159265358979323846264338;
+            for (unsigned i = 0; i < static_cast<unsigned>(Filter_Octave::SAMPLEFILTER_TAP_NUM); i++)
+                m_taps[i] = Filter_Octave::filter_taps[i];
+            for (unsigned i = 0; i < NUM_CHANNELS / 2; i++)
+                m_twiddle.push_back(std::polar(1.0, TwoPi * i / NUM_CHANNELS));
+            for (unsigned k = 0; k < NUM_CHANNELS; k++)
+            {
+                // channels above NUM_CHANNELS/2 are the negative frequencies
+                int channel = k < NUM_CHANNELS / 2 ? static_cast<int>(k) : static_cast<int>(k) - static_cast<int>(NUM_CHANNELS);
+                double outputCenterKHz = inputCenterKHz + channel * OUTPUT_IQ_SAMPLES_PER_SECOND / 1000.;
+                // the same constant phase as Process's mix oscillator
+                std::complex<double> A = std::polar(1.0, CNco::TablePhase(channel));
+                m_outputPhase.push_back(A * std::polar(1.0, -TwoPi * k * (DECIMATE - 1) / NUM_CHANNELS));
+                m_outputs.emplace_back(new WavOutput(ChannelFileName(outputFileName, outputCenterKHz), 
+                    outputCenterKHz, outputStartTime, expectedFrames, outputContainer));
+            }
+        }
+
+        void ProcessChunk(unsigned char* p, unsigned numFrames)
+        {
+            for (auto q = reinterpret_cast<Sample_t*>(p); numFrames > 0; numFrames -= 1)
+            {
+                float inI = static_cast<float>(*q++);
+                float inQ = static_cast<float>(*q++);
+                m_historyI[m_lastIndex] = inI;
+                m_historyI[m_lastIndex + m_len] = inI;
+                m_historyQ[m_lastIndex] = inQ;
+                m_historyQ[m_lastIndex + m_len] = inQ;
+                if (++m_lastIndex >= m_len)
+                    m_lastIndex = 0;
+                if (++m_outputDecimate < DECIMATE)
+                    continue;
+                m_outputDecimate = 0;
+
+                // x[n - i] is at pI[-i]
+                const double* pI = &m_historyI[m_lastIndex + m_len - 1];
+                const double* pQ = &m_historyQ[m_lastIndex + m_len - 1];
+                for (unsigned p = 0; p < NUM_CHANNELS; p++)
+                {
+                    double vI = 0;
+                    double vQ = 0;
+                    for (unsigned i = p; i < m_len; i += NUM_CHANNELS)
+                    {
+                        vI += m_taps[i] * *(pI - i);
+                        vQ += m_taps[i] * *(pQ - i);
+                    }
+                    m_v[p] = std::complex<double>(vI, vQ);
+                }
+                InverseFFT(&m_v[0], NUM_CHANNELS, m_twiddle);
+                for (unsigned k = 0; k < NUM_CHANNELS; k++)
+                {
+                    auto v = m_v[k] * m_outputPhase[k];
+                    m_outputs[k]->Write(v.real(), v.imag());
+                }
+            }
+        }
+
+        void Flush()
+        {
+            for (auto& o : m_outputs)
+                o->Flush();
+        }
+
+        void Finish()
+        {
+            for (auto& o : m_outputs)
+                o->Finish();
+        }
+    private:
+        const unsigned m_len; // Filter_Octave taps rounded up to a multiple of NUM_CHANNELS
+        std::vector<double> m_taps;
+        std::vector<double> m_historyI;
+        std::vector<double> m_historyQ;
+        unsigned m_lastIndex;
+        unsigned m_outputDecimate;
+        std::vector<std::complex<double>> m_v;
+        std::vector<std::complex<double>> m_twiddle;
+        std::vector<std::complex<double>> m_outputPhase;
+        std::vector<std::unique_ptr<WavOutput>> m_outputs;
+    };
+
+    template <class Sample_t, unsigned SCALE>
+    std::shared_ptr<NextBuffer> createOutput(const SliceJob& job, double inputCenterKHz, uint64_t expectedFrames)
+    {
+        if (job.channelize)
+            return std::make_shared<Channelizer<Sample_t>>(job.outputFileName, inputCenterKHz, job.outputStartTime, expectedFrames,
+                job.outputContainer);
+        return std::make_shared<Process<Sample_t, SCALE>>(job.outputFileName, job.outputCenterKHz - inputCenterKHz, job.outputCenterKHz,
+            job.outputStartTime, job.decimatorType, expectedFrames, job.outputContainer, job.inputFramesToProcess);
+    }
+
+    const unsigned READ_AHEAD_BUFFERS = 8;
+    const unsigned READ_AHEAD_BUFFER_BYTES = 1 << 20;
+
+    // returns true if rr is reading ahead
+    bool setInputReader(RiffSequence& rr, InputReaderType inputReader)
+    {
+        if (inputReader == InputReaderType::STREAM)
+            return false;
+        if (inputReader == InputReaderType::MAP && rr.MapFiles())
+            return false;
+        rr.ReadAhead(READ_AHEAD_BUFFERS, READ_AHEAD_BUFFER_BYTES);
+        return true;
+    }
+
+    void addReadAheadStats(CReadAhead::Stats& total, const CReadAhead::Stats& s)
+    {
+        total.buffersRead += s.buffersRead;
+        total.consumerStalls += s.consumerStalls;
+        total.readerStalls += s.readerStalls;
+        total.maxQueueDepth = std::max(total.maxQueueDepth, s.maxQueueDepth);
+    }
+
+    void reportReadAheadStats(const CReadAhead::Stats& s)
+    {
+        std::cerr << "Read ahead: " << s.buffersRead << " buffers read. Processing waited for input " << s.consumerStalls
+            << " times. Input waited for processing " << s.readerStalls << " times. Maximum queue depth " 
+            << s.maxQueueDepth << " of " << READ_AHEAD_BUFFERS << std::endl;
+    }
+
+    // Longer than the history of any of the decimators (the halfband chain's is about 800 input frames)
+    const unsigned WARMUP_FRAMES = 256 * DECIMATE;
+
+    // Process input frames beginFrame through endFrame-1 of the job on this thread, reading and writing
+    // through files of its own. The output goes to outputPosition in the job's output file.
+    template <class Sample_t, unsigned SCALE>
+    CReadAhead::Stats sliceSegment(const std::vector<std::string>& inputFileNames, InputReaderType inputReader, const SliceJob& job, 
+        double inputCenterKHz, uint64_t beginFrame, uint64_t endFrame, uint64_t outputPosition)
+    {
+        RiffSequence rr(inputFileNames);
+        setInputReader(rr, inputReader);
+        rr.ParseHeader();
+        if (!rr.FindDataChunk())
+            throw std::runtime_error("Input \"" + inputFileNames.front() + "\" has no data");
+        Process<Sample_t, SCALE> segment(job.outputFileName, outputPosition, job.outputCenterKHz - inputCenterKHz, job.decimatorType);
+        unsigned warmup = static_cast<unsigned>(std::min<uint64_t>(beginFrame, WARMUP_FRAMES));
+        segment.StartAt(beginFrame - warmup, warmup, endFrame - beginFrame + warmup);
+        // and the lead past the end, as far as the input goes, just as the single thread reads it
+        const uint64_t totalFrames = rr.get_dataChunkSize() / rr.get_blockAlign();
+        const uint64_t lead = std::min<uint64_t>(inputLead(job), totalFrames - (job.inputFramesToSkip + endFrame));
+        rr.ProcessFrames(job.inputFramesToSkip + beginFrame - warmup, endFrame - beginFrame + warmup + lead,
+            [&segment](unsigned char* p, unsigned numFrames)
+            {
+                segment.ProcessChunk(p, numFrames);
+                return true;
+            });
+        segment.Finish();
+        return rr.get_readAheadStats();
+    }
+
+    // Split the job into one segment per thread, each a multiple of DECIMATE input frames,
+    // and write them all into the one output file.
+    template <class Sample_t, unsigned SCALE>
+    int sliceThreaded(RiffSequence& rr, const std::vector<std::string>& inputFileNames, InputReaderType inputReader, const SliceJob& job, 
+        double inputCenterKHz, unsigned threads, CReadAhead::Stats& readAheadStats)
+    {
+        const uint64_t totalFrames = rr.get_dataChunkSize() / rr.get_blockAlign();
+        if (job.inputFramesToSkip >= totalFrames)
+        {
+            std::cerr << "Input ended before the start of " << job.outputFileName << std::endl;
+            return 0;
+        }
+        const uint64_t jobFrames = std::min(job.inputFramesToProcess, totalFrames - job.inputFramesToSkip);
+        const uint64_t segmentFrames = ((jobFrames + threads - 1) / threads + DECIMATE - 1) / DECIMATE * DECIMATE;
+
+        // the header's sizes, and the disk space for all the segments, are set here.
+        std::unique_ptr<WavOutput> header;
+        try {
+            header.reset(new WavOutput(job.outputFileName, job.outputCenterKHz, job.outputStartTime, jobFrames / DECIMATE, job.outputContainer));
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        const uint64_t dataPosition = header->get_dataPosition();
+
+        std::vector<std::string> errors(threads);
+        std::vector<CReadAhead::Stats> stats(threads);
+        std::vector<std::thread> workers;
+        for (unsigned i = 0; i < threads && i * segmentFrames < jobFrames; i++)
+        {
+            uint64_t beginFrame = i * segmentFrames;
+            uint64_t endFrame = std::min(beginFrame + segmentFrames, jobFrames);
+            uint64_t outputPosition = dataPosition + (beginFrame / DECIMATE) * STEREO * sizeof(float);
+            workers.emplace_back([&, i, beginFrame, endFrame, outputPosition]()
+            {
+                try {
+                    stats[i] = sliceSegment<Sample_t, SCALE>(inputFileNames, inputReader, job, inputCenterKHz, beginFrame, endFrame, outputPosition);
+                }
+                catch (const std::exception& e)
+                {
+                    errors[i] = e.what();
+                }
+            });
+        }
+        for (auto& w : workers)
+            w.join();
+        for (auto& s : stats)
+            addReadAheadStats(readAheadStats, s);
+
+        int ret = 0;
+        for (auto& e : errors)
+            if (!e.empty())
+            {
+                std::cerr << e << std::endl;
+                ret = 1;
+            }
+        header->AddSegmentBytes((jobFrames / DECIMATE) * STEREO * sizeof(float));
+        header->Finish();
+        return ret;
+    }
+
+    // A job's output only exists while the read cursor is inside the job's frames (and the lead past them.)
+    struct ActiveJob {
+        ActiveJob(const SliceJob& job)
+            : job(job)
+            , beginFrame(job.inputFramesToSkip)
+            , endFrame(job.inputFramesToProcess > UINT64_MAX - job.inputFramesToSkip ?
+                UINT64_MAX : job.inputFramesToSkip + job.inputFramesToProcess)
+            , leadEndFrame(endFrame > UINT64_MAX - inputLead(job) ? UINT64_MAX : endFrame + inputLead(job))
+            , finished(false)
+        {}
+        const SliceJob& job;
+        uint64_t beginFrame;
+        uint64_t endFrame;
+        uint64_t leadEndFrame;
+        bool finished;
+        std::shared_ptr<NextBuffer> output;
+    };
+
+    int process(const std::vector<std::string>& inputFileNames, double inputCenterKHz, 
+        std::vector<SliceJob>& jobs, unsigned threads, InputReaderType inputReader, unsigned followSeconds)
     {
-        RiffReader rr(inputFile);
+        std::unique_ptr<RiffSequence> input;
+        try {
+            input.reset(new RiffSequence(inputFileNames));
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        RiffSequence& rr = *input;
+        const bool readingAhead = setInputReader(rr, inputReader);
 
         try {
             rr.ParseHeader();
@@ -449,465 +1516,147 @@ namespace {
             return 1;
         }
 
-        std::shared_ptr<NextBuffer> pOutput;
-
         auto format = rr.get_format();
         auto bitsPerSample = rr.get_bitsPerSample();
         auto blockAlign = rr.get_blockAlign();
 
+        std::function<std::shared_ptr<NextBuffer>(const SliceJob&, uint64_t)> create;
+        std::function<int(const SliceJob&)> slice;
+        CReadAhead::Stats threadStats;
         if (format == 1 && bitsPerSample == 16)
-            pOutput.reset(new Process<int16_t, 0x7FFFu>(outputFile,  outputCenterKHz- inputCenterKHz, outputCenterKHz,  outputStartTime));
+        {
+            create = [inputCenterKHz](const SliceJob& job, uint64_t expectedFrames) { return createOutput<int16_t, 0x7FFFu>(job, inputCenterKHz, expectedFrames); };
+            slice = [&](const SliceJob& job) { return sliceThreaded<int16_t, 0x7FFFu>(rr, inputFileNames, inputReader, job, inputCenterKHz, threads, threadStats); };
+        }
         else if (format == 3 && bitsPerSample == 32)
-            pOutput.reset(new Process<float>(outputFile, outputCenterKHz - inputCenterKHz, outputCenterKHz, outputStartTime));
+        {
+            create = [inputCenterKHz](const SliceJob& job, uint64_t expectedFrames) { return createOutput<float, 1>(job, inputCenterKHz, expectedFrames); };
+            slice = [&](const SliceJob& job) { return sliceThreaded<float, 1>(rr, inputFileNames, inputReader, job, inputCenterKHz, threads, threadStats); };
+        }
         else {
             std::cerr << "Cannot process format number " << format << " with bits per sample=" << bitsPerSample << std::endl;
             return 1;
         }
 
-        // set up a couple of function objects for the RiffReader to call us back with
+        // In input order, so the one read of the input passes each job's frames in turn.
+        std::stable_sort(jobs.begin(), jobs.end(), [](const SliceJob& a, const SliceJob& b) 
+            { return a.inputFramesToSkip < b.inputFramesToSkip; });
+
+        if (threads > 1)
+        {   // the threads take turns at each job, in order
+            if (!rr.FindDataChunk())
+            {
+                std::cerr << "Input has no data chunk" << std::endl;
+                return 1;
+            }
+            for (auto& job : jobs)
+                if (slice(job) != 0)
+                    return 1;
+            if (readingAhead)
+                reportReadAheadStats(threadStats);
+            return 0;
+        }
+        std::vector<std::unique_ptr<ActiveJob>> active;
+        for (auto& job : jobs)
+            active.emplace_back(new ActiveJob(job));
+
+        bool failed = false;
+        uint64_t cursor = 0; // the input frame number at p
+        unsigned nextJob = 0; // the first job that has not started
+        unsigned remaining = static_cast<unsigned>(active.size());
 
-        RiffReader::DataChunkFcn_t procFcn = [pOutput, blockAlign, &inputFramesToProcess] (unsigned char *p, unsigned numFrames)
+        // the RiffSequence calls us back here
+        RiffReader::DataChunkFcn_t dataFcn = [&](unsigned char* p, unsigned numFrames)
         {
-            numFrames = std::min(inputFramesToProcess, numFrames);
-            if (numFrames > 0)
+            if (nextJob < active.size() && remaining == static_cast<unsigned>(active.size() - nextJob)
+                && cursor < active[nextJob]->beginFrame)
+            {   // nothing to do until the next job starts. skip forward to it.
+                cursor = active[nextJob]->beginFrame;
+                if (cursor >= rr.get_dataChunkSize() / blockAlign)
+                {
+                    if (followSeconds == 0)
+                        return false;
+                    cursor = rr.get_dataChunkSize() / blockAlign; // and wait there for the recorder to get to it
+                }
+                rr.SeekToFrameNumber(cursor);
+                return true;
+            }
+            const uint64_t chunkEnd = cursor + numFrames;
+            for (; nextJob < active.size() && active[nextJob]->beginFrame < chunkEnd; nextJob++)
             {
-                pOutput->ProcessChunk(p, numFrames);
-                inputFramesToProcess -= numFrames;
+                auto& a = *active[nextJob];
+                // the input's length is known by now, so the output's is too. (Unless it is still being recorded,
+                // or is coming down a pipe that doesn't say. The job's interval is then all there is to go by.)
+                uint64_t inputEnd = std::min(a.endFrame, rr.get_dataChunkSize() / blockAlign);
+                if (!rr.get_dataChunkSizeKnown())
+                    inputEnd = a.endFrame == UINT64_MAX ? a.beginFrame : a.endFrame;
+                try {
+                    a.output = create(a.job, followSeconds != 0 ? 0 : (inputEnd - a.beginFrame) / DECIMATE);
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << e.what() << std::endl;
+                    failed = true;
+                    return false;
+                }
             }
-            return inputFramesToProcess != 0;
+            for (unsigned i = 0; i < nextJob; i++)
+            {
+                auto& a = *active[i];
+                if (a.finished)
+                    continue;
+                uint64_t first = std::max(a.beginFrame, cursor);
+                uint64_t last = std::min(a.leadEndFrame, chunkEnd);
+                if (first < last)
+                    a.output->ProcessChunk(p + static_cast<size_t>(first - cursor) * blockAlign, static_cast<unsigned>(last - first));
+                if (a.leadEndFrame <= chunkEnd)
+                {   // retire this one
+                    a.output->Finish();
+                    a.output.reset();
+                    a.finished = true;
+                    remaining -= 1;
+                }
+            }
+            cursor = chunkEnd;
+            return remaining != 0;
         };
 
-        RiffReader::DataChunkFcn_t dataFcn = procFcn;
-        
-        if (inputFramesToSkip)
-            dataFcn = [inputFramesToSkip, &rr, &dataFcn, &procFcn] (unsigned char *, unsigned)
-            {
-                // update the file handle
-                rr.SeekToFrameNumber(inputFramesToSkip);
-                // overwrite the function object so next call processes after the skip.
-                dataFcn = procFcn;
+        // At the end of what has been recorded so far: wait for more, if following.
+        CFileWatcher watcher;
+        if (followSeconds != 0)
+            watcher.Open(rr.get_lastFileName()); // else Wait polls
+        auto lastGrowth = std::chrono::steady_clock::now();
+        RiffReader::AtEndFcn_t atEnd = [&]()
+        {
+            if (followSeconds == 0 || failed || remaining == 0)
                 return true;
-            };
+            for (unsigned i = 0; i < nextJob; i++)
+                if (active[i]->output)
+                    active[i]->output->Flush();
+            for (;;)
+            {
+                if (rr.ExtendDataChunk())
+                {
+                    lastGrowth = std::chrono::steady_clock::now();
+                    return false;
+                }
+                if (!rr.get_dataChunkGrowing() ||
+                    std::chrono::steady_clock::now() - lastGrowth >= std::chrono::seconds(followSeconds))
+                    return true;
+                watcher.Wait(FOLLOW_POLL_MSEC);
+            }
+        };
 
-        rr.ProcessChunks(dataFcn);
+        rr.ProcessChunks(dataFcn, RiffReader::RiffChunkFcn_t(), atEnd);
 
-        pOutput->Finish();
-        return 0;
+        // end of input. finish those still active.
+        for (auto& a : active)
+            if (a->output)
+                a->output->Finish();
+        if (nextJob < active.size() && !failed)
+            std::cerr << "Input ended before the start of " << active.size() - nextJob << " job(s)" << std::endl;
+        if (readingAhead)
+            reportReadAheadStats(rr.get_readAheadStats());
+        return failed ? 1 : 0;
     }
 }
-
-// past here be filter coefficients
-
-namespace Filter_Octave {
-    /*  f = 10500 / 192000
-        b = fir1(400, f)
-        fd = fopen("d:/temp/10500.txt", "w")
-        fprintf(fd, "%10g,\n", b)
-        fclose(fd)    
-    */
-    FilterCoeficient_t filter_taps[SAMPLEFILTER_TAP_NUM] =
-    {
-9.81549e-05,
-0.000113028,
-0.000125003,
-0.000133747,
-0.000138991,
-0.000140533,
-0.000138247,
-0.000132085,
-0.000122087,
-0.000108378,
-9.11761e-05,
-7.07902e-05,
-4.76195e-05,
-2.21512e-05,
--5.0452e-06,
--3.33251e-05,
--6.19794e-05,
--9.02473e-05,
--0.000117332,
--0.000142418,
--0.000164694,
--0.000183369,
--0.000197705,
--0.000207032,
--0.000210779,
--0.000208495,
--0.000199871,
--0.000184762,
--0.000163201,
--0.000135412,
--0.000101821,
--6.3053e-05,
--1.99308e-05,
-2.65357e-05,
-7.51676e-05,
-0.00012464,
-0.000173515,
-0.000220272,
-0.000263358,
-0.000301225,
-0.000332383,
-0.00035545,
-0.000369202,
-0.000372621,
-0.000364943,
-0.000345696,
-0.000314735,
-0.000272269,
-0.000218875,
-0.000155506,
-8.34812e-05,
-4.4726e-06,
--7.95297e-05,
--0.000166258,
--0.000253224,
--0.000337777,
--0.000417186,
--0.000488713,
--0.000549702,
--0.000597669,
--0.000630382,
--0.000645954,
--0.000642917,
--0.000620295,
--0.000577656,
--0.000515165,
--0.000433605,
--0.00033439,
--0.000219556,
--9.17314e-05,
-4.59135e-05,
-0.000189734,
-0.000335699,
-0.000479496,
-0.000616647,
-0.000742642,
-0.000853072,
-0.000943775,
-0.00101097,
-0.00105141,
-0.00106247,
-0.00104232,
-0.000989951,
-0.00090531,
-0.000789308,
-0.000643857,
-0.000471856,
-0.000277154,
-6.44747e-05,
--0.000160681,
--0.000392166,
--0.000623345,
--0.000847271,
--0.00105688,
--0.0012452,
--0.00140558,
--0.00153186,
--0.00161866,
--0.0016615,
--0.00165701,
--0.0016031,
--0.00149905,
--0.00134562,
--0.00114506,
--0.000901154,
--0.000619154,
--0.000305683,
-3.13903e-05,
-0.000383135,
-0.000739776,
-0.00109095,
-0.00142598,
-0.00173418,
- 0.0020052,
-0.00222931,
-0.00239773,
-0.00250293,
-0.00253893,
-0.00250151,
-0.00238844,
-0.00219962,
-0.00193719,
-0.00160553,
-0.00121129,
-0.000763231,
-0.000272113,
--0.000249564,
--0.000787838,
--0.00132763,
--0.00185312,
--0.00234822,
--0.00279696,
--0.00318403,
--0.00349518,
--0.00371776,
--0.0038411,
--0.00385691,
--0.00375964,
--0.0035468,
--0.00321907,
--0.00278054,
--0.00223866,
--0.00160425,
--0.000891279,
--0.000116672,
-0.00070006,
-0.00153725,
-0.00237156,
-0.00317861,
-0.00393353,
-0.00461173,
-0.00518951,
-0.00564479,
-0.00595784,
-0.00611187,
-0.00609368,
-0.00589418,
-0.00550887,
-0.00493815,
-0.00418761,
-0.00326811,
-0.00219578,
-0.000991891,
--0.000317443,
--0.00170168,
--0.0031264,
--0.00455392,
--0.00594414,
--0.00725529,
--0.00844495,
--0.00947096,
--0.0102925,
--0.0108709,
--0.0111709,
--0.0111614,
--0.0108164,
--0.0101158,
--0.00904593,
--0.00760025,
--0.00577968,
--0.00359284,
--0.00105609,
-0.00180654,
-0.00496366,
-0.00837698,
- 0.0120019,
- 0.0157883,
- 0.0196813,
- 0.0236227,
- 0.0275515,
- 0.0314056,
- 0.0351226,
- 0.0386417,
-  0.041904,
- 0.0448545,
- 0.0474431,
- 0.0496252,
-  0.051363,
- 0.0526265,
- 0.0533936,
- 0.0536507,
- 0.0533936,
- 0.0526265,
-  0.051363,
- 0.0496252,
- 0.0474431,
- 0.0448545,
-  0.041904,
- 0.0386417,
- 0.0351226,
- 0.0314056,
- 0.0275515,
- 0.0236227,
- 0.0196813,
- 0.0157883,
- 0.0120019,
-0.00837698,
-0.00496366,
-0.00180654,
--0.00105609,
--0.00359284,
--0.00577968,
--0.00760025,
--0.00904593,
--0.0101158,
--0.0108164,
--0.0111614,
--0.0111709,
--0.0108709,
--0.0102925,
--0.00947096,
--0.00844495,
--0.00725529,
--0.00594414,
--0.00455392,
--0.0031264,
--0.00170168,
--0.000317443,
-0.000991891,
-0.00219578,
-0.00326811,
-0.00418761,
-0.00493815,
-0.00550887,
-0.00589418,
-0.00609368,
-0.00611187,
-0.00595784,
-0.00564479,
-0.00518951,
-0.00461173,
-0.00393353,
-0.00317861,
-0.00237156,
-0.00153725,
-0.00070006,
--0.000116672,
--0.000891279,
--0.00160425,
--0.00223866,
--0.00278054,
--0.00321907,
--0.0035468,
--0.00375964,
--0.00385691,
--0.0038411,
--0.00371776,
--0.00349518,
--0.00318403,
--0.00279696,
--0.00234822,
--0.00185312,
--0.00132763,
--0.000787838,
--0.000249564,
-0.000272113,
-0.000763231,
-0.00121129,
-0.00160553,
-0.00193719,
-0.00219962,
-0.00238844,
-0.00250151,
-0.00253893,
-0.00250293,
-0.00239773,
-0.00222931,
- 0.0020052,
-0.00173418,
-0.00142598,
-0.00109095,
-0.000739776,
-0.000383135,
-3.13903e-05,
--0.000305683,
--0.000619154,
--0.000901154,
--0.00114506,
--0.00134562,
--0.00149905,
--0.0016031,
--0.00165701,
--0.0016615,
--0.00161866,
--0.00153186,
--0.00140558,
--0.0012452,
--0.00105688,
--0.000847271,
--0.000623345,
--0.000392166,
--0.000160681,
-6.44747e-05,
-0.000277154,
-0.000471856,
-0.000643857,
-0.000789308,
-0.00090531,
-0.000989951,
-0.00104232,
-0.00106247,
-0.00105141,
-0.00101097,
-0.000943775,
-0.000853072,
-0.000742642,
-0.000616647,
-0.000479496,
-0.000335699,
-0.000189734,
-4.59135e-05,
--9.17314e-05,
--0.000219556,
--0.00033439,
--0.000433605,
--0.000515165,
--0.000577656,
--0.000620295,
--0.000642917,
--0.000645954,
--0.000630382,
--0.000597669,
--0.000549702,
--0.000488713,
--0.000417186,
--0.000337777,
--0.000253224,
--0.000166258,
--7.95297e-05,
-4.4726e-06,
-8.34812e-05,
-0.000155506,
-0.000218875,
-0.000272269,
-0.000314735,
-0.000345696,
-0.000364943,
-0.000372621,
-0.000369202,
-0.00035545,
-0.000332383,
-0.000301225,
-0.000263358,
-0.000220272,
-0.000173515,
-0.00012464,
-7.51676e-05,
-2.65357e-05,
--1.99308e-05,
--6.3053e-05,
--0.000101821,
--0.000135412,
--0.000163201,
--0.000184762,
--0.000199871,
--0.000208495,
--0.000210779,
--0.000207032,
--0.000197705,
--0.000183369,
--0.000164694,
--0.000142418,
--0.000117332,
--9.02473e-05,
--6.19794e-05,
--3.33251e-05,
--5.0452e-06,
-2.21512e-05,
-4.76195e-05,
-7.07902e-05,
-9.11761e-05,
-0.000108378,
-0.000122087,
-0.000132085,
-0.000138247,
-0.000140533,
-0.000138991,
-0.000133747,
-0.000125003,
-0.000113028,
-9.81549e-05,
-    };
-}
-
@@ -0,0 +1,267 @@
+/* Copyright (c) 2022, Wayne Wright, W5XD. All rights reserved. */
+
+/* SliceIQTest
+** Command line program that runs SliceIQ on an input it makes up, and checks that outputs that are
+** supposed to be identical are, byte for byte, and that those that are supposed to line up in time do.
+**
+** The input is three seconds of 192KHz float I/Q with tones at several offsets from its center, plus noise.
+** Each check slices it at several output centers.
+**   threads: --threads=7 against --threads=1. The segment boundaries land in the middle of the
+**      oscillator's and the filters' blocks, so this catches any state that depends on where a call starts.
+**   readers: --inputReader=stream and readahead against map. Each hands the frames over in different size
+**      pieces, which must not show in the output.
+**   decimators: --decimator=halfband and cic, cross correlated against the default fir, at a center with
+**      only noise in its passband. The peak must be at lag zero, for --outputStartTime to mean the same
+**      instant whatever the decimator. And --threads=7 against --threads=1 for each of them.
+**
+** SliceIQTest <SliceIQ executable> [<scratch directory>]
+**      The input and output files are written to the scratch directory (default, the current one) and
+**      removed if all the checks pass. Exits with 1 if any failed.
+*/
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <iterator>
+#include <complex>
+
+namespace {
+    const int INPUT_IQ_SAMPLES_PER_SECOND = 192000;
+    const int INPUT_SECONDS = 3;
+    const double INPUT_CENTER_KHZ = 14000;
+    // The tones, relative to the input center. None is a whole number of cycles per block.
+    const double TONE_HZ[] = { -45123.5, 3017.25, 71041.75 };
+    // An output center with none of the tones in its passband, only the noise.
+    const double NOISE_CENTER_KHZ = 13910;
+    // The output centers. The differences being checked for are in the last bit of a sample here and
+    // there, and each of these showed some before CNco anchored its phasor to absolute frames.
+    const double OUTPUT_CENTER_KHZ[] = { 13910, 13970, 14046, 14085 };
+
+#if defined(_WIN32)
+    const char NULL_DEVICE[] = "NUL";
+#else
+    const char NULL_DEVICE[] = "/dev/null";
+#endif
+
+    std::string sliceIQ;
+    std::string scratch;
+    std::vector<std::string> filesWritten;
+
+    std::string scratchFile(const std::string& name)
+    {
+        std::string ret = scratch.empty() ? name : scratch + "/" + name;
+        filesWritten.push_back(ret);
+        return ret;
+    }
+
+    template <class T>
+    void put(std::ofstream& f, T v)
+    {   // little endian, as RIFF is, on the machines this runs on
+        f.write(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    bool writeInput(const std::string& fileName)
+    {
+        std::ofstream f(fileName, std::ios::binary);
+        if (!f)
+            return false;
+        const uint32_t numFrames = INPUT_IQ_SAMPLES_PER_SECOND * INPUT_SECONDS;
+        const uint32_t dataBytes = numFrames * 2 * sizeof(float);
+        f.write("RIFF", 4);
+        put<uint32_t>(f, 4 + 8 + 16 + 8 + dataBytes);
+        f.write("WAVEfmt ", 8);
+        put<uint32_t>(f, 16);
+        put<uint16_t>(f, 3); // WAVE_FORMAT_IEEE_FLOAT
+        put<uint16_t>(f, 2);
+        put<uint32_t>(f, INPUT_IQ_SAMPLES_PER_SECOND);
+        put<uint32_t>(f, INPUT_IQ_SAMPLES_PER_SECOND * 2 * sizeof(float));
+        put<uint16_t>(f, 2 * sizeof(float));
+        put<uint16_t>(f, 32);
+        f.write("data", 4);
+        put<uint32_t>(f, dataBytes);
+
+        static const double TwoPi = 2. * 3.14159265358979323846264338;
+        std::mt19937 generator(12345);
+        std::normal_distribution<double> noise(0, 0.001);
+        for (uint32_t i = 0; i < numFrames; i++)
+        {
+            double I = noise(generator);
+            double Q = noise(generator);
+            for (double hz : TONE_HZ)
+            {
+                double w = TwoPi * hz * i / INPUT_IQ_SAMPLES_PER_SECOND;
+                I += 0.1 * cos(w);
+                Q += 0.1 * sin(w);
+            }
+            put<float>(f, static_cast<float>(I));
+            put<float>(f, static_cast<float>(Q));
+        }
+        return static_cast<bool>(f);
+    }
+
+    bool runSliceIQ(const std::string& input, const std::string& output, const std::string& args)
+    {
+        std::string cmd = "\"" + sliceIQ + "\" \"" + input + "\" \"" + output + "\" " + args + " > " + NULL_DEVICE + " 2>&1";
+#if defined(_WIN32)
+        cmd = "\"" + cmd + "\""; // cmd /c strips the outer quotes
+#endif
+        if (std::system(cmd.c_str()) != 0)
+        {
+            std::cout << "    failed: " << cmd << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    std::vector<char> readFile(const std::string& fileName)
+    {
+        std::ifstream f(fileName, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    }
+
+    // The I/Q samples of one of SliceIQ's float outputs
+    std::vector<std::complex<double>> readSamples(const std::string& fileName)
+    {
+        std::vector<std::complex<double>> ret;
+        std::vector<char> contents = readFile(fileName);
+        for (size_t pos = 12; pos + 8 <= contents.size(); )
+        {
+            uint32_t size;
+            memcpy(&size, &contents[pos + 4], sizeof(size));
+            if (memcmp(&contents[pos], "data", 4) != 0)
+            {
+                pos += 8 + size;
+                continue;
+            }
+            const size_t numFrames = std::min<size_t>(size, contents.size() - pos - 8) / (2 * sizeof(float));
+            const float* p = reinterpret_cast<const float*>(&contents[pos + 8]);
+            for (size_t i = 0; i < numFrames; i++, p += 2)
+                ret.emplace_back(p[0], p[1]);
+            break;
+        }
+        return ret;
+    }
+
+    // Slice input with each of the args, and check the outputs are identical to the first one's.
+    bool checkIdentical(const std::string& name, const std::string& input, const std::vector<std::string>& args)
+    {
+        bool ok = true;
+        for (double centerKHz : OUTPUT_CENTER_KHZ)
+        {
+            const std::string center = std::to_string(static_cast<int>(centerKHz));
+            // inputStartTime defaults to now, which is written into the output's header
+            const std::string common = "--inputCenterKHz=" + std::to_string(static_cast<int>(INPUT_CENTER_KHZ)) +
+                " --inputStartTime=2022/09/08-14:00:00 --outputCenterKHz=" + center + " ";
+            std::vector<char> first;
+            for (unsigned i = 0; i < args.size(); i++)
+            {
+                const std::string output = scratchFile("SliceIQTest_" + name + "_" + center + "_" + std::to_string(i) + ".wav");
+                if (!runSliceIQ(input, output, common + args[i]))
+                    return false;
+                std::vector<char> contents = readFile(output);
+                if (i == 0)
+                    first = contents;
+                else if (contents != first)
+                {
+                    std::cout << "    " << center << "KHz: " << args[i] << " differs from " << args[0] << std::endl;
+                    ok = false;
+                }
+            }
+        }
+        std::cout << name << (ok ? ": ok" : ": FAILED") << std::endl;
+        return ok;
+    }
+
+    // Slice input with the fir decimator and with each of the others, and check that their
+    // cross correlation peaks at lag zero.
+    bool checkAligned(const std::string& input, const std::vector<std::string>& decimators)
+    {
+        static const int MAX_LAG = 40; // output frames, either way
+        const std::string common = "--inputCenterKHz=" + std::to_string(static_cast<int>(INPUT_CENTER_KHZ)) +
+            " --inputStartTime=2022/09/08-14:00:00 --outputCenterKHz=" + std::to_string(static_cast<int>(NOISE_CENTER_KHZ)) + " ";
+        const std::string firOutput = scratchFile("SliceIQTest_aligned_fir.wav");
+        if (!runSliceIQ(input, firOutput, common + "--decimator=fir"))
+            return false;
+        const auto fir = readSamples(firOutput);
+        bool ok = true;
+        for (const auto& d : decimators)
+        {
+            const std::string output = scratchFile("SliceIQTest_aligned_" + d + ".wav");
+            if (!runSliceIQ(input, output, common + "--decimator=" + d))
+                return false;
+            const auto other = readSamples(output);
+            if (other.size() != fir.size())
+            {
+                std::cout << "    " << d << " has " << other.size() << " frames, and fir " << fir.size() << std::endl;
+                ok = false;
+                continue;
+            }
+            int bestLag = 0;
+            double best = 0;
+            double atZero = 0;
+            for (int lag = -MAX_LAG; lag <= MAX_LAG; lag++)
+            {   // skipping the ends, where the filters are still filling
+                std::complex<double> sum = 0;
+                for (int n = 2 * MAX_LAG; n < static_cast<int>(fir.size()) - 2 * MAX_LAG; n++)
+                    sum += std::conj(fir[n]) * other[n + lag];
+                if (lag == 0)
+                    atZero = std::abs(sum);
+                if (std::abs(sum) > best)
+                {
+                    best = std::abs(sum);
+                    bestLag = lag;
+                }
+            }
+            if (bestLag != 0)
+            {
+                std::cout << "    " << d << ": peak at lag " << bestLag << ", where lag 0 is " << atZero / best << " of it" << std::endl;
+                ok = false;
+            }
+        }
+        std::cout << "decimators aligned" << (ok ? ": ok" : ": FAILED") << std::endl;
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: SliceIQTest <SliceIQ executable> [<scratch directory>]" << std::endl;
+        return 1;
+    }
+    sliceIQ = argv[1];
+    if (argc > 2)
+        scratch = argv[2];
+
+    const std::string input = scratchFile("SliceIQTest_input.wav");
+    if (!writeInput(input))
+    {
+        std::cerr << "Failed to write " << input << std::endl;
+        return 1;
+    }
+
+    bool ok = true;
+    if (!checkIdentical("threads", input, { "--threads=1", "--threads=7" }))
+        ok = false;
+    if (!checkIdentical("readers", input, { "--inputReader=map", "--inputReader=stream", "--inputReader=readahead" }))
+        ok = false;
+    if (!checkAligned(input, { "halfband", "cic" }))
+        ok = false;
+    if (!checkIdentical("halfband threads", input, { "--decimator=halfband --threads=1", "--decimator=halfband --threads=7" }))
+        ok = false;
+    if (!checkIdentical("cic threads", input, { "--decimator=cic --threads=1", "--decimator=cic --threads=7" }))
+        ok = false;
+
+    if (ok)
+        for (const auto& f : filesWritten)
+            std::remove(f.c_str());
+    std::cout << (ok ? "All passed" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}